@@ -18,4 +18,46 @@
 #define APP_CONFIG_DEFAULT_MAXIMUM_PRESSURE_THRESHOLD 1020//950
 #define APP_CONFIG_MAXIMUM_PRESSURE_THRESHOLD         1200
 
+#define APP_CONFIG_MINIMUM_PRESSURE_OSR       256
+#define APP_CONFIG_MAXIMUM_PRESSURE_OSR       8192
+#define APP_CONFIG_DEFAULT_PRESSURE_OSR       8192
+#define APP_CONFIG_MAXIMUM_PRESSURE_WINDOW    200
+#define APP_CONFIG_DEFAULT_PRESSURE_WINDOW    200
+#define APP_CONFIG_MAXIMUM_PRESSURE_PERIOD_MS 250     // 0 samples as fast as the oversampling ratio allows
+#define APP_CONFIG_DEFAULT_PRESSURE_PERIOD_MS 0
+
+// Number of MS5837 pressure (D1) conversions for each temperature (D2) conversion
+#define APP_CONFIG_PRESSURE_CONVERSIONS_PER_TEMPERATURE 16
+
+// Samples further than this from the median of the last three are discarded as corrupted reads
+#define APP_CONFIG_PRESSURE_SPIKE_THRESHOLD_PA     2000
+#define APP_CONFIG_TEMPERATURE_ADC_SPIKE_THRESHOLD 30000     // About 1 C of MS5837 D2 counts
+
+// The pressure derivative is a least-squares slope over a window of samples taken every period (6.4 s)
+#define APP_CONFIG_PRESSURE_SLOPE_PERIOD_MS 100
+#define APP_CONFIG_PRESSURE_SLOPE_WINDOW    64
+
+// Per channel statistics are collected over windows of this many seconds, or until read in reset-on-read mode
+#define APP_CONFIG_MAXIMUM_STATISTICS_WINDOW_S      3600
+#define APP_CONFIG_DEFAULT_STATISTICS_WINDOW_S      60
+#define APP_CONFIG_DEFAULT_STATISTICS_RESET_ON_READ 0
+
+#define APP_CONFIG_SHTC3_PERIOD_MS 200
+// Use the SHTC3 low power measurement mode: faster and with less self heating, but noisier
+#define APP_CONFIG_SHTC3_LOW_POWER 0
+
+// Length of the windows over which sampling rate and jitter statistics are collected
+#define APP_CONFIG_TIMING_WINDOW_MS 10000UL
+
+// Refresh period of the status LEDs; the controller otherwise sleeps until an event wakes it up
+#define APP_CONFIG_LED_PERIOD_MS 50
+
+// The safety task samples the safety input every period and drives the approval output; it runs below the pressure
+// sampler and above everything else
+#define APP_CONFIG_SAFETY_PERIOD_MS     10
+#define APP_CONFIG_SAFETY_TASK_PRIORITY 4
+
+// Requests are served by their own task as soon as a complete frame is received, above the controller and console
+#define APP_CONFIG_MODBUS_TASK_PRIORITY 3
+
 #endif
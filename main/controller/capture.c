@@ -0,0 +1,113 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "capture.h"
+
+
+/*
+ *  Oscilloscope-like capture of the raw MS5837 samples.
+ *  While armed the sampler keeps overwriting a ring of the latest samples; after a trigger it records
+ *  CAPTURE_POST_TRIGGER_SAMPLES more and then freezes the buffer until it is armed again.
+ *  The buffer is only written by the sampling task and only read while frozen, so no lock is needed:
+ *  trigger and arm requests from other tasks are flags that the sampler consumes on its next sample.
+ */
+
+
+static capture_sample_t samples[CAPTURE_SAMPLES] = {0};
+static size_t           head                     = 0;     // Next position to write
+static size_t           count                    = 0;     // Valid samples in the buffer
+static size_t           remaining                = 0;     // Samples still to record after the trigger
+static size_t           trigger_position         = 0;     // Chronological index of the first sample after the trigger
+
+static atomic_int  state           = CAPTURE_STATE_ARMED;
+static atomic_bool trigger_request = 0;
+static atomic_bool arm_request     = 0;
+
+
+void capture_add_sample(uint32_t timestamp, uint32_t pressure_adc, uint32_t temperature_adc) {
+    if (atomic_exchange(&arm_request, 0)) {
+        count = 0;
+        head  = 0;
+        atomic_store(&trigger_request, 0);
+        atomic_store(&state, CAPTURE_STATE_ARMED);
+    }
+
+    switch (atomic_load(&state)) {
+        case CAPTURE_STATE_ARMED:
+            if (atomic_exchange(&trigger_request, 0)) {
+                trigger_position = count;
+                remaining        = CAPTURE_POST_TRIGGER_SAMPLES;
+                atomic_store(&state, CAPTURE_STATE_TRIGGERED);
+            }
+            break;
+
+        case CAPTURE_STATE_TRIGGERED:
+            break;
+
+        default:
+            return;
+    }
+
+    samples[head] = (capture_sample_t){
+        .timestamp       = timestamp,
+        .pressure_adc    = pressure_adc,
+        .temperature_adc = temperature_adc,
+    };
+    head = (head + 1) % CAPTURE_SAMPLES;
+
+    if (count < CAPTURE_SAMPLES) {
+        count++;
+    } else if (atomic_load(&state) == CAPTURE_STATE_TRIGGERED) {
+        // The oldest pre-trigger sample was overwritten
+        trigger_position--;
+    }
+
+    if (atomic_load(&state) == CAPTURE_STATE_TRIGGERED && --remaining == 0) {
+        atomic_store(&state, CAPTURE_STATE_FROZEN);
+    }
+}
+
+
+void capture_trigger(void) {
+    atomic_store(&trigger_request, 1);
+}
+
+
+void capture_arm(void) {
+    atomic_store(&arm_request, 1);
+}
+
+
+capture_state_t capture_get_state(void) {
+    return (capture_state_t)atomic_load(&state);
+}
+
+
+size_t capture_get_count(void) {
+    return capture_get_state() == CAPTURE_STATE_FROZEN ? count : 0;
+}
+
+
+size_t capture_get_trigger_position(void) {
+    return capture_get_state() == CAPTURE_STATE_FROZEN ? trigger_position : 0;
+}
+
+
+/*
+ *  Copies frozen samples in chronological order, starting from the `first` oldest one.
+ *  Returns the number of samples copied, 0 if the capture is not frozen.
+ */
+size_t capture_read(size_t first, capture_sample_t *buffer, size_t len) {
+    if (capture_get_state() != CAPTURE_STATE_FROZEN) {
+        return 0;
+    }
+
+    size_t oldest = (head + CAPTURE_SAMPLES - count) % CAPTURE_SAMPLES;
+    size_t copied = 0;
+
+    for (size_t i = first; i < count && copied < len; i++) {
+        buffer[copied++] = samples[(oldest + i) % CAPTURE_SAMPLES];
+    }
+
+    return copied;
+}
@@ -0,0 +1,37 @@
+#ifndef CAPTURE_H_INCLUDED
+#define CAPTURE_H_INCLUDED
+
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+#define CAPTURE_PRE_TRIGGER_SAMPLES  64
+#define CAPTURE_POST_TRIGGER_SAMPLES 64
+#define CAPTURE_SAMPLES              (CAPTURE_PRE_TRIGGER_SAMPLES + CAPTURE_POST_TRIGGER_SAMPLES)
+
+
+typedef enum {
+    CAPTURE_STATE_ARMED = 0,
+    CAPTURE_STATE_TRIGGERED,
+    CAPTURE_STATE_FROZEN,
+} capture_state_t;
+
+
+typedef struct {
+    uint32_t timestamp;
+    uint32_t pressure_adc;
+    uint32_t temperature_adc;
+} capture_sample_t;
+
+
+void            capture_add_sample(uint32_t timestamp, uint32_t pressure_adc, uint32_t temperature_adc);
+void            capture_trigger(void);
+void            capture_arm(void);
+capture_state_t capture_get_state(void);
+size_t          capture_get_count(void);
+size_t          capture_get_trigger_position(void);
+size_t          capture_read(size_t first, capture_sample_t *samples, size_t count);
+
+
+#endif
@@ -0,0 +1,88 @@
+#include <stdlib.h>
+#include "compensation.h"
+
+
+// Bits 5 to 11 of the first PROM word identify the sensor; the 30BA (0x1A) needs different formulas
+#define PROM_VERSION(prom)    (((prom)[0] >> 5) & 0x7F)
+#define VERSION_MS5837_02BA01 0x00
+#define VERSION_MS5837_02BA21 0x15
+
+
+static uint8_t crc4(const uint16_t *prom);
+
+
+/*
+ *  Validates the PROM content and caches the compensation constants.
+ *  Returns -1 if the CRC stored in the first PROM word does not match and -2 if the PROM does not identify one of
+ *  the 02BA versions, whose formulas are the only ones implemented.
+ */
+int compensation_ms5837_init(compensation_ms5837_t *compensation, const uint16_t *prom) {
+    if (crc4(prom) != (prom[0] >> 12)) {
+        return -1;
+    }
+    if (PROM_VERSION(prom) != VERSION_MS5837_02BA01 && PROM_VERSION(prom) != VERSION_MS5837_02BA21) {
+        return -2;
+    }
+
+    compensation->sensitivity             = ((int64_t)prom[1]) << 16;
+    compensation->offset                  = ((int64_t)prom[2]) << 17;
+    compensation->sensitivity_temperature = prom[3];
+    compensation->offset_temperature      = prom[4];
+    compensation->reference_temperature   = ((int64_t)prom[5]) << 8;
+    compensation->temperature_sensitivity = prom[6];
+
+    return 0;
+}
+
+
+/*
+ *  Integer first and second order compensation for the MS5837-02BA (0-2 bar) variant.
+ *  Returns the pressure in Pa (0.01 mBar) and optionally the temperature in 0.01 C.
+ */
+int32_t compensation_ms5837_calculate(const compensation_ms5837_t *compensation, uint32_t temperature_adc,
+                                      uint32_t pressure_adc, int32_t *temperature) {
+    int64_t delta_temperature = (int64_t)temperature_adc - compensation->reference_temperature;
+    int64_t temp              = 2000 + ((delta_temperature * compensation->temperature_sensitivity) >> 23);
+    int64_t offset            = compensation->offset + ((compensation->offset_temperature * delta_temperature) >> 6);
+    int64_t sensitivity =
+        compensation->sensitivity + ((compensation->sensitivity_temperature * delta_temperature) >> 7);
+
+    // Second order compensation, only needed below 20 C
+    if (temp < 2000) {
+        int64_t low = (temp - 2000) * (temp - 2000);
+        temp -= (11 * delta_temperature * delta_temperature) >> 35;
+        offset -= (31 * low) >> 3;
+        sensitivity -= (63 * low) >> 5;
+    }
+
+    if (temperature != NULL) {
+        *temperature = (int32_t)temp;
+    }
+
+    return (int32_t)(((((int64_t)pressure_adc * sensitivity) >> 21) - offset) >> 15);
+}
+
+
+static uint8_t crc4(const uint16_t *prom) {
+    uint16_t remainder = 0;
+
+    for (size_t i = 0; i < (COMPENSATION_MS5837_PROM_WORDS + 1) * 2; i++) {
+        uint16_t word = 0;
+        if (i / 2 < COMPENSATION_MS5837_PROM_WORDS) {
+            // The CRC itself is stored in the top nibble of the first word and is excluded
+            word = i / 2 == 0 ? (prom[0] & 0x0FFF) : prom[i / 2];
+        }
+
+        remainder ^= (i % 2) ? (word & 0x00FF) : (word >> 8);
+
+        for (size_t bit = 0; bit < 8; bit++) {
+            if (remainder & 0x8000) {
+                remainder = (remainder << 1) ^ 0x3000;
+            } else {
+                remainder = remainder << 1;
+            }
+        }
+    }
+
+    return (remainder >> 12) & 0x000F;
+}
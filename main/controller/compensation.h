@@ -0,0 +1,30 @@
+#ifndef COMPENSATION_H_INCLUDED
+#define COMPENSATION_H_INCLUDED
+
+
+#include <stdint.h>
+
+
+#define COMPENSATION_MS5837_PROM_WORDS 7
+
+
+/*
+ *  MS5837 compensation constants, derived once from the PROM coefficients so that each sample only costs a
+ *  handful of integer multiplications and shifts.
+ */
+typedef struct {
+    int64_t sensitivity;                  // C1 * 2^16
+    int64_t offset;                       // C2 * 2^17
+    int64_t sensitivity_temperature;      // C3
+    int64_t offset_temperature;           // C4
+    int64_t reference_temperature;        // C5 * 2^8
+    int64_t temperature_sensitivity;      // C6
+} compensation_ms5837_t;
+
+
+int     compensation_ms5837_init(compensation_ms5837_t *compensation, const uint16_t *prom);
+int32_t compensation_ms5837_calculate(const compensation_ms5837_t *compensation, uint32_t temperature_adc,
+                                      uint32_t pressure_adc, int32_t *temperature);
+
+
+#endif
@@ -6,6 +6,8 @@
 #include "peripherals/storage.h"
 #include "easyconnect_interface.h"
 #include "configuration.h"
+#include "sensors.h"
+#include "filter.h"
 
 
 #define ADDRESS_KEY                  "indirizzo"
@@ -15,6 +17,15 @@
 #define MAXIMUM_PRESSURE_KEY         "MAXPRESS"
 #define MINIMUM_PRESSURE_MESSAGE_KEY "MINPRESSMSG"
 #define MAXIMUM_PRESSURE_MESSAGE_KEY "MAXPRESSMSG"
+#define PRESSURE_OSR_KEY             "PRESSOSR"
+#define PRESSURE_WINDOW_KEY          "PRESSWINDOW"
+#define PRESSURE_PERIOD_KEY          "PRESSPERIOD"
+#define PRESSURE_SLOPE_ALARM_KEY     "SLOPEALARM"
+#define STATISTICS_WINDOW_KEY        "STATSWINDOW"
+#define STATISTICS_RESET_KEY         "STATSRESET"
+#define PRESSURE_FILTER_KEY          "PRESSFILTER"
+#define TEMPERATURE_FILTER_KEY       "TEMPFILTER"
+#define HUMIDITY_FILTER_KEY          "HUMFILTER"
 
 
 void configuration_init(model_t *pmodel) {
@@ -31,16 +42,47 @@ void configuration_init(model_t *pmodel) {
         model_set_class(pmodel, value, NULL);
     }
     if (load_uint16_option(&value, MINIMUM_PRESSURE_KEY) == 0) {
-        model_set_minimum_pressure(pmodel, value);
+        model_set_minimum_pressure(pmodel, value, NULL);
     }
     if (load_uint16_option(&value, MAXIMUM_PRESSURE_KEY) == 0) {
-        model_set_maximum_pressure(pmodel, value);
+        model_set_maximum_pressure(pmodel, value, NULL);
+    }
+    if (load_uint16_option(&value, PRESSURE_OSR_KEY) == 0) {
+        model_set_pressure_osr(pmodel, value);
+    }
+    if (load_uint16_option(&value, PRESSURE_WINDOW_KEY) == 0) {
+        model_set_pressure_window(pmodel, value);
+    }
+    if (load_uint16_option(&value, PRESSURE_PERIOD_KEY) == 0) {
+        model_set_pressure_period(pmodel, value);
+    }
+    if (load_uint16_option(&value, PRESSURE_SLOPE_ALARM_KEY) == 0) {
+        model_set_pressure_slope_alarm(pmodel, value);
+    }
+    if (load_uint16_option(&value, STATISTICS_WINDOW_KEY) == 0) {
+        model_set_statistics_window(pmodel, value);
+    }
+    if (load_uint16_option(&value, STATISTICS_RESET_KEY) == 0 && model_is_statistics_reset_on_read_valid(value)) {
+        model_set_statistics_reset_on_read(pmodel, value);
+    }
+    if (load_uint16_option(&value, PRESSURE_FILTER_KEY) == 0 && value < FILTER_TYPE_NUM) {
+        model_set_pressure_filter(pmodel, value);
+    }
+    if (load_uint16_option(&value, TEMPERATURE_FILTER_KEY) == 0 && value < FILTER_TYPE_NUM) {
+        model_set_temperature_filter(pmodel, value);
+    }
+    if (load_uint16_option(&value, HUMIDITY_FILTER_KEY) == 0 && value < FILTER_TYPE_NUM) {
+        model_set_humidity_filter(pmodel, value);
     }
 
-    load_blob_option(pmodel->minimum_pressure_message, sizeof(pmodel->minimum_pressure_message),
-                     MINIMUM_PRESSURE_MESSAGE_KEY);
-    load_blob_option(pmodel->maximum_pressure_message, sizeof(pmodel->maximum_pressure_message),
-                     MAXIMUM_PRESSURE_MESSAGE_KEY);
+    char message[EASYCONNECT_MESSAGE_SIZE + 1] = {0};
+    if (load_blob_option(message, sizeof(message) - 1, MINIMUM_PRESSURE_MESSAGE_KEY) == 0) {
+        model_set_minimum_pressure_message(pmodel, message);
+    }
+    memset(message, 0, sizeof(message));
+    if (load_blob_option(message, sizeof(message) - 1, MAXIMUM_PRESSURE_MESSAGE_KEY) == 0) {
+        model_set_maximum_pressure_message(pmodel, message);
+    }
 }
 
 
@@ -68,7 +110,8 @@ void configuration_save_address(void *args, uint16_t value) {
 
 
 int configuration_save_minimum_pressure(void *args, uint16_t value) {
-    if (model_set_minimum_pressure(args, value) == 0) {
+    // The sampler gets both thresholds as they are in the model, even if the other one is changed concurrently
+    if (model_set_minimum_pressure(args, value, sensors_set_pressure_thresholds) == 0) {
         save_uint16_option(&value, MINIMUM_PRESSURE_KEY);
         return 0;
     } else {
@@ -78,7 +121,7 @@ int configuration_save_minimum_pressure(void *args, uint16_t value) {
 
 
 int configuration_save_maximum_pressure(void *args, uint16_t value) {
-    if (model_set_maximum_pressure(args, value) == 0) {
+    if (model_set_maximum_pressure(args, value, sensors_set_pressure_thresholds) == 0) {
         save_uint16_option(&value, MAXIMUM_PRESSURE_KEY);
         return 0;
     } else {
@@ -87,6 +130,116 @@ int configuration_save_maximum_pressure(void *args, uint16_t value) {
 }
 
 
+int configuration_save_pressure_osr(void *args, uint16_t value) {
+    if (model_set_pressure_osr(args, value) == 0) {
+        save_uint16_option(&value, PRESSURE_OSR_KEY);
+        // The sampler picks up the new setting on its next conversion, no reboot needed
+        sensors_set_pressure_sampling(value, model_get_pressure_window(args), model_get_pressure_period(args));
+        return 0;
+    } else {
+        return -1;
+    }
+}
+
+
+int configuration_save_pressure_window(void *args, uint16_t value) {
+    if (model_set_pressure_window(args, value) == 0) {
+        save_uint16_option(&value, PRESSURE_WINDOW_KEY);
+        sensors_set_pressure_sampling(model_get_pressure_osr(args), value, model_get_pressure_period(args));
+        return 0;
+    } else {
+        return -1;
+    }
+}
+
+
+int configuration_save_pressure_period(void *args, uint16_t value) {
+    if (model_set_pressure_period(args, value) == 0) {
+        save_uint16_option(&value, PRESSURE_PERIOD_KEY);
+        sensors_set_pressure_sampling(model_get_pressure_osr(args), model_get_pressure_window(args), value);
+        return 0;
+    } else {
+        return -1;
+    }
+}
+
+
+/*
+ *  Saves the three sampling settings together and restarts the sampler once; nothing changes unless all are valid
+ */
+int configuration_save_pressure_sampling(void *args, uint16_t osr, uint16_t window, uint16_t period) {
+    if (!model_is_pressure_osr_valid(osr) || !model_is_pressure_window_valid(window) ||
+        !model_is_pressure_period_valid(period)) {
+        return -1;
+    }
+
+    model_set_pressure_osr(args, osr);
+    model_set_pressure_window(args, window);
+    model_set_pressure_period(args, period);
+    save_uint16_option(&osr, PRESSURE_OSR_KEY);
+    save_uint16_option(&window, PRESSURE_WINDOW_KEY);
+    save_uint16_option(&period, PRESSURE_PERIOD_KEY);
+    sensors_set_pressure_sampling(osr, window, period);
+    return 0;
+}
+
+
+void configuration_save_pressure_slope_alarm(void *args, uint16_t value) {
+    save_uint16_option(&value, PRESSURE_SLOPE_ALARM_KEY);
+    model_set_pressure_slope_alarm(args, value);
+}
+
+
+int configuration_save_statistics_window(void *args, uint16_t value) {
+    if (model_set_statistics_window(args, value) == 0) {
+        save_uint16_option(&value, STATISTICS_WINDOW_KEY);
+        sensors_set_statistics(value, model_get_statistics_reset_on_read(args));
+        return 0;
+    } else {
+        return -1;
+    }
+}
+
+
+int configuration_save_statistics_reset_on_read(void *args, uint16_t value) {
+    if (!model_is_statistics_reset_on_read_valid(value)) {
+        return -1;
+    }
+
+    save_uint16_option(&value, STATISTICS_RESET_KEY);
+    model_set_statistics_reset_on_read(args, value);
+    sensors_set_statistics(model_get_statistics_window(args), value);
+    return 0;
+}
+
+
+int configuration_save_filter(void *args, sensors_channel_t channel, uint16_t type) {
+    if (type >= FILTER_TYPE_NUM) {
+        return -1;
+    }
+
+    switch (channel) {
+        case SENSORS_CHANNEL_PRESSURE:
+            save_uint16_option(&type, PRESSURE_FILTER_KEY);
+            model_set_pressure_filter(args, type);
+            break;
+        case SENSORS_CHANNEL_TEMPERATURE:
+            save_uint16_option(&type, TEMPERATURE_FILTER_KEY);
+            model_set_temperature_filter(args, type);
+            break;
+        case SENSORS_CHANNEL_HUMIDITY:
+            save_uint16_option(&type, HUMIDITY_FILTER_KEY);
+            model_set_humidity_filter(args, type);
+            break;
+        default:
+            return -1;
+    }
+
+    sensors_set_filter(channel, type);
+    return 0;
+}
+
+
 void configuration_save_minimum_pressure_message(void *args, const char *string) {
     save_blob_option((char *)string, strlen(string), MINIMUM_PRESSURE_MESSAGE_KEY);
     model_set_minimum_pressure_message(args, string);
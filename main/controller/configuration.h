@@ -4,6 +4,7 @@
 
 #include <stdint.h>
 #include "model/model.h"
+#include "sensors.h"
 
 
 void configuration_init(model_t *pmodel);
@@ -12,6 +13,14 @@ int  configuration_save_class(void *args, uint16_t value);
 void configuration_save_address(void *args, uint16_t value);
 int  configuration_save_minimum_pressure(void *args, uint16_t value);
 int  configuration_save_maximum_pressure(void *args, uint16_t value);
+int  configuration_save_pressure_osr(void *args, uint16_t value);
+int  configuration_save_pressure_window(void *args, uint16_t value);
+int  configuration_save_pressure_period(void *args, uint16_t value);
+int  configuration_save_pressure_sampling(void *args, uint16_t osr, uint16_t window, uint16_t period);
+void configuration_save_pressure_slope_alarm(void *args, uint16_t value);
+int  configuration_save_statistics_window(void *args, uint16_t value);
+int  configuration_save_statistics_reset_on_read(void *args, uint16_t value);
+int  configuration_save_filter(void *args, sensors_channel_t channel, uint16_t type);
 void configuration_save_minimum_pressure_message(void *args, const char *string);
 void configuration_save_maximum_pressure_message(void *args, const char *string);
 
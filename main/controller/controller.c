@@ -1,6 +1,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/timers.h"
+#include "freertos/event_groups.h"
 #include "controller.h"
 #include "gel/timer/timecheck.h"
 #include "utils/utils.h"
@@ -16,15 +18,21 @@
 #include "esp_log.h"
 #include "device_commands.h"
 #include "safety.h"
-#include "approval.h"
 #include "sensors.h"
+#include "profiler.h"
 #include "leds_communication.h"
 #include "leds_activity.h"
 
 
+// Reasons for the controller task to wake up; Modbus requests are served by the minion task
+#define EVENT_LED_TIMER 0x01
+#define EVENT_ALL       (EVENT_LED_TIMER)
+
+
 static void    console_task(void *args);
 static void    delay_ms(unsigned long ms);
 static uint8_t get_inputs(void *args);
+static void    led_timer(TimerHandle_t timer);
 
 
 static easyconnect_interface_t context = {
@@ -39,16 +47,30 @@ static easyconnect_interface_t context = {
     .write_response     = rs485_write,
 };
 
-static const char *TAG = "Controller";
+static const char        *TAG = "Controller";
+static EventGroupHandle_t events;
 
 
 void controller_init(model_t *pmodel) {
     (void)TAG;
     context.arg = pmodel;
 
+    static StaticEventGroup_t event_group_buffer;
+    events = xEventGroupCreateStatic(&event_group_buffer);
+
     configuration_init(pmodel);
+
     minion_init(&context);
 
+    sensors_set_pressure_sampling(model_get_pressure_osr(pmodel), model_get_pressure_window(pmodel),
+                                  model_get_pressure_period(pmodel));
+    sensors_set_filter(SENSORS_CHANNEL_PRESSURE, model_get_pressure_filter(pmodel));
+    sensors_set_filter(SENSORS_CHANNEL_TEMPERATURE, model_get_temperature_filter(pmodel));
+    sensors_set_filter(SENSORS_CHANNEL_HUMIDITY, model_get_humidity_filter(pmodel));
+    sensors_set_pressure_thresholds(model_get_minimum_pressure(pmodel), model_get_maximum_pressure(pmodel));
+    sensors_set_statistics(model_get_statistics_window(pmodel), model_get_statistics_reset_on_read(pmodel));
+    // The approval output is driven by its own task, so bus traffic and NVS writes cannot delay it
+    safety_init(pmodel);
     switch (CLASS_GET_MODE(model_get_class(pmodel))) {
         case DEVICE_MODE_PRESSURE:
             sensors_init(1, 0);
@@ -64,40 +86,33 @@ void controller_init(model_t *pmodel) {
     static uint8_t      stack_buffer[APP_CONFIG_BASE_TASK_STACK_SIZE * 6];
     static StaticTask_t task_buffer;
     xTaskCreateStatic(console_task, "Console", sizeof(stack_buffer), &context, 1, stack_buffer, &task_buffer);
+
+    static StaticTimer_t timer_buffer;
+    TimerHandle_t        timer =
+        xTimerCreateStatic("timerLed", pdMS_TO_TICKS(APP_CONFIG_LED_PERIOD_MS), pdTRUE, NULL, led_timer, &timer_buffer);
+    xTimerStart(timer, portMAX_DELAY);
 }
 
 
+/*
+ *  Sleeps until the LEDs are due for a refresh
+ */
 void controller_manage(model_t *pmodel) {
-    static unsigned long timestamp = 0;
-
-    minion_manage();
-
-    if (is_expired(timestamp, get_millis(), 500UL) || digin_is_value_ready()) {
-        double temperature = 0;
-        double pressure    = 0;
-        double humidity    = 0;
-
-        sensors_read(&temperature, &pressure, &humidity);
-        int16_t pascal_pressure = (int16_t)((pressure - 1013.25) * 100);
-        model_set_temperature(pmodel, (int16_t)temperature);
-        model_set_humidity(pmodel, (int16_t)humidity);
-        model_set_pressure(pmodel, pascal_pressure);
-
-        uint8_t safety_signal   = safety_signal_ok(pmodel);
-        uint8_t safety_pressure = safety_pressure_ok(pmodel);
-
-        if (safety_signal && safety_pressure && !model_get_missing_heartbeat(pmodel)) {
-            approval_on();
-        } else {
-            approval_off();
-        }
-
-        timestamp = get_millis();
+    (void)pmodel;
+
+    EventBits_t bits = xEventGroupWaitBits(events, EVENT_ALL, pdTRUE, pdFALSE, portMAX_DELAY);
+
+    if (bits & EVENT_LED_TIMER) {
+        // The LEDs only mirror what the safety task last decided
+        PROFILER_BEGIN(PROFILER_STAGE_LED_UPDATE);
+        uint8_t       status = safety_get_status();
+        unsigned long now    = get_millis();
+        digout_update(DIGOUT_LED_APPROVAL,
+                      (leds_communication_manage(now, (status & SAFETY_STATUS_HEARTBEAT_OK) > 0)));
+        digout_update(DIGOUT_LED_SAFETY, (leds_activity_manage(now, (status & SAFETY_STATUS_PRESSURE_OK) > 0,
+                                                               (status & SAFETY_STATUS_SIGNAL_OK) > 0, 1)));
+        PROFILER_END(PROFILER_STAGE_LED_UPDATE);
     }
-
-    digout_update(DIGOUT_LED_APPROVAL, (leds_communication_manage(get_millis(), !model_get_missing_heartbeat(pmodel))));
-    digout_update(DIGOUT_LED_SAFETY,
-                  (leds_activity_manage(get_millis(), safety_pressure_ok(pmodel), safety_signal_ok(pmodel), 1)));
 }
 
 
@@ -126,3 +141,9 @@ static uint8_t get_inputs(void *args) {
     (void)args;
     return (uint8_t)digin_get_inputs();
 }
+
+
+static void led_timer(TimerHandle_t timer) {
+    (void)timer;
+    xEventGroupSetBits(events, EVENT_LED_TIMER);
+}
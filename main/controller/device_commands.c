@@ -2,6 +2,7 @@
 #include "esp_console.h"
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include <fcntl.h>
 #include "linenoise/linenoise.h"
 #include "argtable3/argtable3.h"
@@ -11,6 +12,8 @@
 #include "model/model.h"
 #include "configuration.h"
 #include "sensors.h"
+#include "safety.h"
+#include "profiler.h"
 
 
 static int command_read_sensors(int argc, char **argv);
@@ -18,11 +21,26 @@ static int command_read_min_pressure(int argc, char **argv);
 static int command_set_min_pressure(int argc, char **argv);
 static int command_read_max_pressure(int argc, char **argv);
 static int command_set_max_pressure(int argc, char **argv);
+static int command_read_pressure_sampling(int argc, char **argv);
+static int command_set_pressure_sampling(int argc, char **argv);
+static int command_read_filters(int argc, char **argv);
+static int command_set_filter(int argc, char **argv);
+static int command_read_timing(int argc, char **argv);
+static int command_read_latency(int argc, char **argv);
+#ifdef CONFIG_EASYCONNECT_PROFILER
+static int command_profile_dump(int argc, char **argv);
+static int command_profile_reset(int argc, char **argv);
+#endif
+static int command_read_slope_alarm(int argc, char **argv);
+static int command_set_slope_alarm(int argc, char **argv);
+static int command_read_statistics(int argc, char **argv);
+static int command_set_statistics(int argc, char **argv);
 static int device_commands_read_inputs(int argc, char **argv);
 static int device_commands_read_minimum_pressure_message(int argc, char **argv);
 static int device_commands_set_minimum_pressure_message(int argc, char **argv);
 static int device_commands_read_maximum_pressure_message(int argc, char **argv);
 static int device_commands_set_maximum_pressure_message(int argc, char **argv);
+static uint8_t argument_valid(int value, uint8_t (*check)(uint16_t value));
 
 
 static model_t *model_ref = NULL;
@@ -79,6 +97,108 @@ void device_commands_register(model_t *pmodel) {
     };
     ESP_ERROR_CHECK(esp_console_cmd_register(&set_max_pressure));
 
+    const esp_console_cmd_t read_pressure_sampling = {
+        .command = "ReadPressureSampling",
+        .help    = "Read the configured pressure oversampling ratio, averaging window and sampling period",
+        .hint    = NULL,
+        .func    = &command_read_pressure_sampling,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&read_pressure_sampling));
+
+    const esp_console_cmd_t set_pressure_sampling = {
+        .command = "SetPressureSampling",
+        .help    = "Set the pressure oversampling ratio (256 to 8192), averaging window (1 to 200 samples) and "
+                   "optionally the sampling period (0 to 250 ms, 0 for back to back conversions)",
+        .hint    = NULL,
+        .func    = &command_set_pressure_sampling,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&set_pressure_sampling));
+
+    const esp_console_cmd_t read_filters = {
+        .command = "ReadFilters",
+        .help    = "Read the filter configured for each channel",
+        .hint    = NULL,
+        .func    = &command_read_filters,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&read_filters));
+
+    const esp_console_cmd_t set_filter = {
+        .command = "SetFilter",
+        .help    = "Set the filter of a channel (0 pressure, 1 temperature, 2 humidity) to moving average (0), EMA "
+                   "(1), median (2) or biquad low-pass (3)",
+        .hint    = NULL,
+        .func    = &command_set_filter,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&set_filter));
+
+    const esp_console_cmd_t read_timing = {
+        .command = "ReadTiming",
+        .help    = "Print sample rate, inter-sample interval and conversion time statistics of the last window and "
+                   "the number of sampling overruns",
+        .hint    = NULL,
+        .func    = &command_read_timing,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&read_timing));
+
+    const esp_console_cmd_t read_latency = {
+        .command = "ReadLatency",
+        .help    = "Print the latency from the safety input opening or the pressure leaving its window to the approval "
+                   "output being written",
+        .hint    = NULL,
+        .func    = &command_read_latency,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&read_latency));
+
+#ifdef CONFIG_EASYCONNECT_PROFILER
+    const esp_console_cmd_t profile_dump = {
+        .command = "ProfileDump",
+        .help    = "Print the duration histograms of the controller stages",
+        .hint    = NULL,
+        .func    = &command_profile_dump,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&profile_dump));
+
+    const esp_console_cmd_t profile_reset = {
+        .command = "ProfileReset",
+        .help    = "Clear the duration histograms of the controller stages",
+        .hint    = NULL,
+        .func    = &command_profile_reset,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&profile_reset));
+#endif
+
+    const esp_console_cmd_t read_slope_alarm = {
+        .command = "ReadSlopeAlarm",
+        .help    = "Read the configured pressure derivative alarm threshold",
+        .hint    = NULL,
+        .func    = &command_read_slope_alarm,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&read_slope_alarm));
+
+    const esp_console_cmd_t set_slope_alarm = {
+        .command = "SetSlopeAlarm",
+        .help    = "Set the pressure derivative alarm threshold in 0.1 Pa/s (0 to disable)",
+        .hint    = NULL,
+        .func    = &command_set_slope_alarm,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&set_slope_alarm));
+
+    const esp_console_cmd_t read_statistics = {
+        .command = "ReadStatistics",
+        .help    = "Print the statistics of each channel and their configuration (never resets them)",
+        .hint    = NULL,
+        .func    = &command_read_statistics,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&read_statistics));
+
+    const esp_console_cmd_t set_statistics = {
+        .command = "SetStatistics",
+        .help    = "Set the statistics window (1 to 3600 s) and reset-on-read mode (0 or 1)",
+        .hint    = NULL,
+        .func    = &command_set_statistics,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&set_statistics));
+
     const esp_console_cmd_t read_minimum_pressure_message = {
         .command = "ReadMinPressureMessage",
         .help    = "Print the configured minimum pressure warning",
@@ -121,13 +241,18 @@ static int command_read_sensors(int argc, char **argv) {
 
     int nerrors = arg_parse(argc, argv, argtable);
     if (nerrors == 0) {
-        double temperature = 0;
-        double pressure    = 0;
-        double humidity    = 0;
+        int16_t temperature = 0;
+        int16_t pressure    = 0;
+        int16_t humidity    = 0;
 
         sensors_read(&temperature, &pressure, &humidity);
 
-        printf("%4.2f C\n%4.2f Pa %4.2f%%\n", temperature, pressure, humidity);
+        printf("%i C\n%i Pa (relative) %i%%\n", temperature, pressure, humidity);
+        printf("%i pressure samples/s\n", sensors_get_pressure_sample_rate());
+        printf("%i rejected pressure samples\n", sensors_get_pressure_rejected_samples());
+
+        int slope = sensors_get_pressure_slope();
+        printf("%s%i.%i Pa/s\n", slope < 0 ? "-" : "", abs(slope) / 10, abs(slope) % 10);
     } else {
         arg_print_errors(stdout, end, "Read sensors values");
     }
@@ -167,7 +292,9 @@ static int command_read_max_pressure(int argc, char **argv) {
 
     int nerrors = arg_parse(argc, argv, argtable);
     if (nerrors == 0) {
-        printf("%i mBar\n", model_get_maximum_pressure(model_ref));
+        model_snapshot_t snapshot = {0};
+        model_get_snapshot(model_ref, &snapshot);
+        printf("%i mBar\n", snapshot.maximum_pressure);
     } else {
         arg_print_errors(stdout, end, "Read maximum pressure");
     }
@@ -207,7 +334,9 @@ static int command_read_min_pressure(int argc, char **argv) {
 
     int nerrors = arg_parse(argc, argv, argtable);
     if (nerrors == 0) {
-        printf("%i mBar\n", model_get_minimum_pressure(model_ref));
+        model_snapshot_t snapshot = {0};
+        model_get_snapshot(model_ref, &snapshot);
+        printf("%i mBar\n", snapshot.minimum_pressure);
     } else {
         arg_print_errors(stdout, end, "Read minimum pressure");
     }
@@ -217,6 +346,325 @@ static int command_read_min_pressure(int argc, char **argv) {
 }
 
 
+static int command_read_slope_alarm(int argc, char **argv) {
+    struct arg_end *end;
+    void           *argtable[] = {
+        end = arg_end(1),
+    };
+
+    int nerrors = arg_parse(argc, argv, argtable);
+    if (nerrors == 0) {
+        model_snapshot_t snapshot = {0};
+        model_get_snapshot(model_ref, &snapshot);
+        printf("%i (0.1 Pa/s)\n", snapshot.pressure_slope_alarm);
+    } else {
+        arg_print_errors(stdout, end, "Read slope alarm");
+    }
+
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return nerrors ? -1 : 0;
+}
+
+
+static int command_set_slope_alarm(int argc, char **argv) {
+    struct arg_end *end;
+    struct arg_int *alarm;
+    void           *argtable[] = {
+        alarm = arg_int1(NULL, NULL, "<int>", "Pressure derivative threshold"),
+        end   = arg_end(1),
+    };
+
+    int nerrors = arg_parse(argc, argv, argtable);
+    if (nerrors == 0) {
+        if (alarm->ival[0] < 0 || alarm->ival[0] > UINT16_MAX) {
+            printf("Invalid value!\n");
+        } else {
+            configuration_save_pressure_slope_alarm(model_ref, alarm->ival[0]);
+        }
+    } else {
+        arg_print_errors(stdout, end, "Set slope alarm");
+    }
+
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return nerrors ? -1 : 0;
+}
+
+
+static int command_read_statistics(int argc, char **argv) {
+    struct arg_end *end;
+    void           *argtable[] = {
+        end = arg_end(1),
+    };
+
+    int nerrors = arg_parse(argc, argv, argtable);
+    if (nerrors == 0) {
+        const char *names[SENSORS_NUM_CHANNELS] = {"Pressure", "Temperature", "Humidity"};
+
+        model_snapshot_t snapshot = {0};
+        model_get_snapshot(model_ref, &snapshot);
+        printf("Window %i s, reset on read %i\n", snapshot.statistics_window, snapshot.statistics_reset_on_read);
+        for (sensors_channel_t channel = 0; channel < SENSORS_NUM_CHANNELS; channel++) {
+            statistics_summary_t summary = {0};
+            sensors_get_statistics(channel, &summary);
+            printf("%s: %u samples, min %i max %i mean %i stddev %i\n", names[channel], (unsigned)summary.count,
+                   (int)summary.min, (int)summary.max, (int)summary.mean, (int)summary.stddev);
+        }
+    } else {
+        arg_print_errors(stdout, end, "Read statistics");
+    }
+
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return nerrors ? -1 : 0;
+}
+
+
+static int command_set_statistics(int argc, char **argv) {
+    struct arg_end *end;
+    struct arg_int *window;
+    struct arg_int *reset_on_read;
+    void           *argtable[] = {
+        window        = arg_int1(NULL, NULL, "<int>", "Window (s)"),
+        reset_on_read = arg_int1(NULL, NULL, "<int>", "Reset on read"),
+        end           = arg_end(2),
+    };
+
+    int nerrors = arg_parse(argc, argv, argtable);
+    if (nerrors == 0) {
+        // Nothing is saved unless every argument is valid
+        if (!argument_valid(window->ival[0], model_is_statistics_window_valid) ||
+            !argument_valid(reset_on_read->ival[0], model_is_statistics_reset_on_read_valid)) {
+            printf("Invalid value!\n");
+        } else {
+            configuration_save_statistics_window(model_ref, window->ival[0]);
+            configuration_save_statistics_reset_on_read(model_ref, reset_on_read->ival[0]);
+        }
+    } else {
+        arg_print_errors(stdout, end, "Set statistics");
+    }
+
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return nerrors ? -1 : 0;
+}
+
+
+static int command_read_pressure_sampling(int argc, char **argv) {
+    struct arg_end *end;
+    void           *argtable[] = {
+        end = arg_end(1),
+    };
+
+    int nerrors = arg_parse(argc, argv, argtable);
+    if (nerrors == 0) {
+        model_snapshot_t snapshot = {0};
+        model_get_snapshot(model_ref, &snapshot);
+        printf("OSR %i, %i samples, period %i ms\n", snapshot.pressure_osr, snapshot.pressure_window,
+               snapshot.pressure_period);
+    } else {
+        arg_print_errors(stdout, end, "Read pressure sampling");
+    }
+
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return nerrors ? -1 : 0;
+}
+
+
+static int command_set_pressure_sampling(int argc, char **argv) {
+    struct arg_end *end;
+    struct arg_int *osr;
+    struct arg_int *window;
+    struct arg_int *period;
+    void           *argtable[] = {
+        osr    = arg_int1(NULL, NULL, "<int>", "Oversampling ratio"),
+        window = arg_int1(NULL, NULL, "<int>", "Averaging window"),
+        period = arg_int0(NULL, NULL, "<int>", "Sampling period (ms)"),
+        end    = arg_end(3),
+    };
+
+    int nerrors = arg_parse(argc, argv, argtable);
+    if (nerrors == 0) {
+        // Nothing is saved unless every argument is valid
+        if (!argument_valid(osr->ival[0], model_is_pressure_osr_valid) ||
+            !argument_valid(window->ival[0], model_is_pressure_window_valid) ||
+            (period->count > 0 && !argument_valid(period->ival[0], model_is_pressure_period_valid))) {
+            printf("Invalid value!\n");
+        } else {
+            uint16_t sampling_period = period->count > 0 ? period->ival[0] : model_get_pressure_period(model_ref);
+            configuration_save_pressure_sampling(model_ref, osr->ival[0], window->ival[0], sampling_period);
+        }
+    } else {
+        arg_print_errors(stdout, end, "Set pressure sampling");
+    }
+
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return nerrors ? -1 : 0;
+}
+
+
+static int command_read_filters(int argc, char **argv) {
+    struct arg_end *end;
+    void           *argtable[] = {
+        end = arg_end(1),
+    };
+
+    int nerrors = arg_parse(argc, argv, argtable);
+    if (nerrors == 0) {
+        model_snapshot_t snapshot = {0};
+        model_get_snapshot(model_ref, &snapshot);
+        printf("Pressure=%i\nTemperature=%i\nHumidity=%i\n", snapshot.pressure_filter, snapshot.temperature_filter,
+               snapshot.humidity_filter);
+    } else {
+        arg_print_errors(stdout, end, "Read filters");
+    }
+
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return nerrors ? -1 : 0;
+}
+
+
+static int command_read_timing(int argc, char **argv) {
+    struct arg_end *end;
+    void           *argtable[] = {
+        end = arg_end(1),
+    };
+
+    int nerrors = arg_parse(argc, argv, argtable);
+    if (nerrors == 0) {
+        const char *names[SENSORS_NUM_DEVICES] = {"MS5837", "SHTC3"};
+
+        for (sensors_device_t device = 0; device < SENSORS_NUM_DEVICES; device++) {
+            timing_summary_t summary = {0};
+            sensors_get_timing(device, &summary);
+
+            printf("%s: %u samples at %u.%u Hz, last at %llu us\n", names[device], (unsigned)summary.samples,
+                   (unsigned)(summary.rate / 10), (unsigned)(summary.rate % 10),
+                   (unsigned long long)sensors_get_sample_timestamp(device));
+            printf("  interval min %u max %u p50 %u p99 %u us\n", (unsigned)summary.interval_min,
+                   (unsigned)summary.interval_max, (unsigned)summary.interval_p50, (unsigned)summary.interval_p99);
+            printf("  conversion min %u max %u us\n", (unsigned)summary.conversion_min,
+                   (unsigned)summary.conversion_max);
+            printf("  %u overruns\n", (unsigned)sensors_get_overruns(device));
+        }
+    } else {
+        arg_print_errors(stdout, end, "Read timing");
+    }
+
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return nerrors ? -1 : 0;
+}
+
+
+static int command_read_latency(int argc, char **argv) {
+    struct arg_end *end;
+    void           *argtable[] = {
+        end = arg_end(1),
+    };
+
+    int nerrors = arg_parse(argc, argv, argtable);
+    if (nerrors == 0) {
+        const char *names[LATENCY_NUM_SOURCES] = {"Safety input", "Pressure"};
+
+        for (latency_source_t source = 0; source < LATENCY_NUM_SOURCES; source++) {
+            latency_summary_t summary = {0};
+            safety_get_latency(source, &summary);
+
+            printf("%s: %u events\n", names[source], (unsigned)summary.count);
+            printf("  p50 %u p90 %u p99 %u max %u us\n", (unsigned)summary.p50, (unsigned)summary.p90,
+                   (unsigned)summary.p99, (unsigned)summary.max);
+            printf("  worst detection %u dispatch %u output %u us\n", (unsigned)summary.detection_max,
+                   (unsigned)summary.dispatch_max, (unsigned)summary.output_max);
+        }
+    } else {
+        arg_print_errors(stdout, end, "Read latency");
+    }
+
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return nerrors ? -1 : 0;
+}
+
+
+#ifdef CONFIG_EASYCONNECT_PROFILER
+static int command_profile_dump(int argc, char **argv) {
+    struct arg_end *end;
+    void           *argtable[] = {
+        end = arg_end(1),
+    };
+
+    int nerrors = arg_parse(argc, argv, argtable);
+    if (nerrors == 0) {
+        const char *names[PROFILER_NUM_STAGES] = {
+            "UART read",  "RTU parse",         "Response write", "Sensor read", "Safety evaluation",
+            "LED update", "Request to response",
+        };
+
+        for (profiler_stage_t stage = 0; stage < PROFILER_NUM_STAGES; stage++) {
+            profiler_histogram_t histogram = {0};
+            profiler_get(stage, &histogram);
+
+            printf("%s: %u runs, mean %u max %u us\n", names[stage], (unsigned)histogram.count,
+                   histogram.count > 0 ? (unsigned)(histogram.total / histogram.count) : 0, (unsigned)histogram.max);
+            for (uint16_t bucket = 0; bucket < PROFILER_NUM_BUCKETS; bucket++) {
+                if (bucket < PROFILER_NUM_BUCKETS - 1) {
+                    printf("  <= %5u us: %u\n", (unsigned)profiler_bucket_limit(bucket),
+                           (unsigned)histogram.buckets[bucket]);
+                } else {
+                    printf("  >  %5u us: %u\n", (unsigned)profiler_bucket_limit(bucket - 1),
+                           (unsigned)histogram.buckets[bucket]);
+                }
+            }
+        }
+    } else {
+        arg_print_errors(stdout, end, "Profile dump");
+    }
+
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return nerrors ? -1 : 0;
+}
+
+
+static int command_profile_reset(int argc, char **argv) {
+    struct arg_end *end;
+    void           *argtable[] = {
+        end = arg_end(1),
+    };
+
+    int nerrors = arg_parse(argc, argv, argtable);
+    if (nerrors == 0) {
+        profiler_reset();
+    } else {
+        arg_print_errors(stdout, end, "Profile reset");
+    }
+
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return nerrors ? -1 : 0;
+}
+#endif
+
+
+static int command_set_filter(int argc, char **argv) {
+    struct arg_end *end;
+    struct arg_int *channel;
+    struct arg_int *type;
+    void           *argtable[] = {
+        channel = arg_int1(NULL, NULL, "<int>", "Channel"),
+        type    = arg_int1(NULL, NULL, "<int>", "Filter type"),
+        end     = arg_end(2),
+    };
+
+    int nerrors = arg_parse(argc, argv, argtable);
+    if (nerrors == 0) {
+        if (channel->ival[0] < 0 || type->ival[0] < 0 ||
+            configuration_save_filter(model_ref, channel->ival[0], type->ival[0])) {
+            printf("Invalid value!\n");
+        }
+    } else {
+        arg_print_errors(stdout, end, "Set filter");
+    }
+
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return nerrors ? -1 : 0;
+}
+
+
 static int device_commands_read_inputs(int argc, char **argv) {
     struct arg_end *end;
     /* the global arg_xxx structs are initialised within the argtable */
@@ -245,9 +693,9 @@ static int device_commands_read_minimum_pressure_message(int argc, char **argv)
 
     int nerrors = arg_parse(argc, argv, argtable);
     if (nerrors == 0) {
-        char minimum_pressure_message[EASYCONNECT_MESSAGE_SIZE + 1] = {0};
-        model_get_minimum_pressure_message(model_ref, minimum_pressure_message);
-        printf("%s\n", minimum_pressure_message);
+        model_snapshot_t snapshot = {0};
+        model_get_snapshot(model_ref, &snapshot);
+        printf("%s\n", snapshot.minimum_pressure_message);
     } else {
         arg_print_errors(stdout, end, "Read minimum pressure message");
     }
@@ -285,9 +733,9 @@ static int device_commands_read_maximum_pressure_message(int argc, char **argv)
 
     int nerrors = arg_parse(argc, argv, argtable);
     if (nerrors == 0) {
-        char maximum_pressure_message[EASYCONNECT_MESSAGE_SIZE + 1] = {0};
-        model_get_maximum_pressure_message(model_ref, maximum_pressure_message);
-        printf("%s\n", maximum_pressure_message);
+        model_snapshot_t snapshot = {0};
+        model_get_snapshot(model_ref, &snapshot);
+        printf("%s\n", snapshot.maximum_pressure_message);
     } else {
         arg_print_errors(stdout, end, "Read maximum pressure message");
     }
@@ -315,3 +763,11 @@ static int device_commands_set_maximum_pressure_message(int argc, char **argv) {
     arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
     return nerrors ? -1 : 0;
 }
+
+
+/*
+ *  Checks an integer parsed by argtable against the model rules without saving anything
+ */
+static uint8_t argument_valid(int value, uint8_t (*check)(uint16_t value)) {
+    return value >= 0 && value <= UINT16_MAX && check(value);
+}
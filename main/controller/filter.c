@@ -0,0 +1,304 @@
+#include <string.h>
+#include "filter.h"
+
+
+#define BIQUAD_FRACTION_BITS 28     // Coefficients are in Q28
+#define BIQUAD_STATE_BITS    8      // Samples and outputs are kept with 8 fractional bits in the biquad state
+#define BIQUAD_NUM_CUTOFFS   6
+
+
+static size_t  median_search(const int32_t *sorted, size_t count, int32_t value);
+static int32_t median_push(filter_t *filter, int32_t sample);
+static uint8_t log2_floor(uint16_t value);
+static int32_t median_of_3(int32_t a, int32_t b, int32_t c);
+
+
+/*
+ *  b0, b1, b2, a1, a2 of second order Butterworth low-pass filters with cutoff at fs/4, fs/8, ..., fs/128.
+ *  b1 is adjusted so that the DC gain is exactly 1.
+ */
+static const int32_t biquad_coefficients[BIQUAD_NUM_CUTOFFS][5] = {
+    {78622925, 157245849, 78622925, 0, 46056243},
+    {26207642, 52415282, 26207642, -253083375, 89478485},
+    {8040872, 16081744, 8040872, -390370540, 154098572},
+    {2266318, 4532636, 2266318, -462722643, 203352459},
+    {604405, 1208809, 604405, -499655328, 233637491},
+    {156250, 312499, 156250, -518243217, 250432760},
+};
+
+
+void filter_init(filter_t *filter, int32_t *buffer, uint16_t capacity) {
+    memset(filter, 0, sizeof(*filter));
+    filter->buffer   = buffer;
+    filter->capacity = capacity;
+    filter_configure(filter, FILTER_TYPE_MOVING_AVERAGE, capacity);
+}
+
+
+void filter_configure(filter_t *filter, filter_type_t type, uint16_t length) {
+    if (length == 0) {
+        length = 1;
+    }
+
+    switch (type) {
+        case FILTER_TYPE_MEDIAN:
+            if (length > FILTER_MEDIAN_MAX_LENGTH) {
+                length = FILTER_MEDIAN_MAX_LENGTH;
+            }
+            // fallthrough
+        case FILTER_TYPE_MOVING_AVERAGE:
+            if (length > filter->capacity) {
+                length = filter->capacity;
+            }
+            break;
+
+        case FILTER_TYPE_EMA:
+            filter->shift = log2_floor(length);
+            break;
+
+        case FILTER_TYPE_BIQUAD: {
+            uint8_t cutoff = log2_floor(length);
+            cutoff         = cutoff < 2 ? 2 : cutoff;
+            cutoff         = cutoff > BIQUAD_NUM_CUTOFFS + 1 ? BIQUAD_NUM_CUTOFFS + 1 : cutoff;
+
+            filter->coefficients = biquad_coefficients[cutoff - 2];
+            break;
+        }
+
+        default:
+            type = FILTER_TYPE_MOVING_AVERAGE;
+            break;
+    }
+
+    filter->type   = type;
+    filter->length = length;
+    filter_reset(filter);
+}
+
+
+void filter_reset(filter_t *filter) {
+    filter->index       = 0;
+    filter->count       = 0;
+    filter->sum         = 0;
+    filter->accumulator = 0;
+}
+
+
+int32_t filter_push(filter_t *filter, int32_t sample) {
+    switch (filter->type) {
+        case FILTER_TYPE_MOVING_AVERAGE:
+            if (filter->count == filter->length) {
+                // Evict the oldest sample from the running sum
+                filter->sum -= filter->buffer[filter->index];
+            } else {
+                filter->count++;
+            }
+            filter->buffer[filter->index] = sample;
+            filter->sum += sample;
+            filter->index = (filter->index + 1) % filter->length;
+            break;
+
+        case FILTER_TYPE_EMA:
+            if (filter->count == 0) {
+                // Start from the first sample instead of ramping up from zero
+                filter->accumulator = ((int64_t)sample) << filter->shift;
+                filter->count       = 1;
+            } else {
+                filter->accumulator += sample - (filter->accumulator >> filter->shift);
+            }
+            break;
+
+        case FILTER_TYPE_MEDIAN:
+            return median_push(filter, sample);
+
+        case FILTER_TYPE_BIQUAD: {
+            const int32_t *c = filter->coefficients;
+            int32_t        x = sample * (1 << BIQUAD_STATE_BITS);
+
+            if (filter->count == 0) {
+                // Start in steady state on the first sample
+                filter->x[0] = filter->x[1] = filter->y[0] = filter->y[1] = x;
+                filter->count                                               = 1;
+            }
+
+            int64_t accumulator = (int64_t)c[0] * x + (int64_t)c[1] * filter->x[0] + (int64_t)c[2] * filter->x[1] -
+                                  (int64_t)c[3] * filter->y[0] - (int64_t)c[4] * filter->y[1];
+
+            filter->x[1] = filter->x[0];
+            filter->x[0] = x;
+            filter->y[1] = filter->y[0];
+            filter->y[0] = (int32_t)(accumulator >> BIQUAD_FRACTION_BITS);
+            break;
+        }
+    }
+
+    return filter_output(filter);
+}
+
+
+int32_t filter_output(filter_t *filter) {
+    if (filter->count == 0) {
+        return 0;
+    }
+
+    switch (filter->type) {
+        case FILTER_TYPE_MOVING_AVERAGE:
+            return (int32_t)(filter->sum / filter->count);
+        case FILTER_TYPE_EMA:
+            return (int32_t)(filter->accumulator >> filter->shift);
+        case FILTER_TYPE_MEDIAN:
+            return filter->sorted[filter->count / 2];
+        case FILTER_TYPE_BIQUAD:
+            return (filter->y[0] + (1 << (BIQUAD_STATE_BITS - 1))) >> BIQUAD_STATE_BITS;
+        default:
+            return 0;
+    }
+}
+
+
+uint8_t filter_is_empty(filter_t *filter) {
+    return filter->count == 0;
+}
+
+
+void spike_gate_init(spike_gate_t *gate, int32_t threshold) {
+    memset(gate, 0, sizeof(*gate));
+    gate->threshold = threshold;
+}
+
+
+/*
+ *  Returns 1 if the sample should be used, 0 if it is an outlier
+ */
+uint8_t spike_gate_accept(spike_gate_t *gate, int32_t sample) {
+    uint8_t accepted = 1;
+
+    if (gate->count < 2) {
+        gate->count++;
+    } else {
+        int32_t median    = median_of_3(gate->history[0], gate->history[1], sample);
+        int32_t deviation = sample > median ? sample - median : median - sample;
+
+        if (deviation > gate->threshold) {
+            gate->rejected++;
+            accepted = 0;
+        }
+    }
+
+    gate->history[0] = gate->history[1];
+    gate->history[1] = sample;
+
+    return accepted;
+}
+
+
+void slope_init(slope_t *slope, int32_t *buffer, uint16_t capacity) {
+    memset(slope, 0, sizeof(*slope));
+    slope->buffer   = buffer;
+    slope->capacity = capacity;
+}
+
+
+void slope_push(slope_t *slope, int32_t sample) {
+    if (slope->count < slope->capacity) {
+        slope->weighted_sum += (int64_t)slope->count * sample;
+        slope->sum += sample;
+        slope->count++;
+    } else {
+        // Every remaining sample moves one position back and the new one takes the last position
+        int32_t oldest = slope->buffer[slope->index];
+        slope->weighted_sum += -(slope->sum - oldest) + (int64_t)(slope->count - 1) * sample;
+        slope->sum += sample - oldest;
+    }
+
+    slope->buffer[slope->index] = sample;
+    slope->index                = (slope->index + 1) % slope->capacity;
+}
+
+
+/*
+ *  Slope in sample units per sample spacing, multiplied by `scale`; 0 until there are at least two samples
+ */
+int32_t slope_estimate(slope_t *slope, int32_t scale) {
+    int64_t n = slope->count;
+    if (n < 2) {
+        return 0;
+    }
+
+    // With positions 0..n-1: slope = (12 * sum(i * y) - 6 * (n - 1) * sum(y)) / (n * (n^2 - 1))
+    int64_t numerator   = (12 * slope->weighted_sum - 6 * (n - 1) * slope->sum) * scale;
+    int64_t denominator = n * (n * n - 1);
+    int64_t result      = numerator / denominator;
+
+    if (result > INT32_MAX) {
+        return INT32_MAX;
+    } else if (result < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)result;
+}
+
+
+static int32_t median_push(filter_t *filter, int32_t sample) {
+    if (filter->count == filter->length) {
+        // Remove the oldest sample from the sorted window
+        size_t position = median_search(filter->sorted, filter->count, filter->buffer[filter->index]);
+        memmove(&filter->sorted[position], &filter->sorted[position + 1],
+                (filter->count - position - 1) * sizeof(int32_t));
+        filter->count--;
+    }
+
+    size_t position = median_search(filter->sorted, filter->count, sample);
+    memmove(&filter->sorted[position + 1], &filter->sorted[position], (filter->count - position) * sizeof(int32_t));
+    filter->sorted[position] = sample;
+    filter->count++;
+
+    filter->buffer[filter->index] = sample;
+    filter->index                 = (filter->index + 1) % filter->length;
+
+    return filter->sorted[filter->count / 2];
+}
+
+
+/*
+ *  First position in the sorted window whose value is not lower than `value`
+ */
+static size_t median_search(const int32_t *sorted, size_t count, int32_t value) {
+    size_t low = 0, high = count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (sorted[middle] < value) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+
+static int32_t median_of_3(int32_t a, int32_t b, int32_t c) {
+    if (a > b) {
+        int32_t tmp = a;
+        a           = b;
+        b           = tmp;
+    }
+    // a <= b
+    if (c <= a) {
+        return a;
+    } else if (c >= b) {
+        return b;
+    } else {
+        return c;
+    }
+}
+
+
+static uint8_t log2_floor(uint16_t value) {
+    uint8_t result = 0;
+    while (value > 1) {
+        value >>= 1;
+        result++;
+    }
+    return result;
+}
@@ -0,0 +1,91 @@
+#ifndef FILTER_H_INCLUDED
+#define FILTER_H_INCLUDED
+
+
+#include <stdint.h>
+
+
+#define FILTER_MEDIAN_MAX_LENGTH 15
+#define FILTER_TYPE_NUM          4
+
+
+typedef enum {
+    FILTER_TYPE_MOVING_AVERAGE = 0,
+    FILTER_TYPE_EMA,
+    FILTER_TYPE_MEDIAN,
+    FILTER_TYPE_BIQUAD,
+} filter_type_t;
+
+
+/*
+ *  Statically allocated digital filter over integer samples.
+ *  The meaning of `length` depends on the type:
+ *   - moving average: number of averaged samples (O(1) update with a running sum)
+ *   - EMA: equivalent window, the smoothing factor is 1/2^k with 2^k the largest power of two <= length (O(1))
+ *   - median: window of at most FILTER_MEDIAN_MAX_LENGTH samples, kept sorted (binary search, O(log N) compares)
+ *   - biquad: second order Butterworth low-pass with cutoff at sample rate / length, rounded down to a power of
+ *     two between 4 and 128 (O(1))
+ */
+typedef struct {
+    filter_type_t type;
+    uint16_t      length;
+
+    // History of the last samples, provided by the owner; used by the moving average and the median
+    int32_t *buffer;
+    uint16_t capacity;
+    uint16_t index;
+    uint16_t count;
+
+    int64_t sum;
+    int64_t accumulator;
+    uint8_t shift;
+
+    int32_t sorted[FILTER_MEDIAN_MAX_LENGTH];
+
+    const int32_t *coefficients;
+    int32_t        x[2];
+    int32_t        y[2];
+} filter_t;
+
+
+/*
+ *  Median-of-3 spike gate: a sample further than `threshold` from the median of itself and the two previous
+ *  samples is rejected. Rejected samples still enter the history, so a genuine step passes after one sample.
+ */
+typedef struct {
+    int32_t  history[2];
+    uint8_t  count;
+    int32_t  threshold;
+    uint32_t rejected;
+} spike_gate_t;
+
+
+/*
+ *  Least-squares slope over a sliding window of equally spaced samples, updated in O(1):
+ *  only the running sums of the samples and of the samples weighted by their position are kept,
+ *  the history (provided by the owner) is needed to remove the oldest sample.
+ */
+typedef struct {
+    int32_t *buffer;
+    uint16_t capacity;
+    uint16_t index;
+    uint16_t count;
+    int64_t  sum;
+    int64_t  weighted_sum;
+} slope_t;
+
+
+void    filter_init(filter_t *filter, int32_t *buffer, uint16_t capacity);
+void    filter_configure(filter_t *filter, filter_type_t type, uint16_t length);
+void    filter_reset(filter_t *filter);
+int32_t filter_push(filter_t *filter, int32_t sample);
+int32_t filter_output(filter_t *filter);
+uint8_t filter_is_empty(filter_t *filter);
+void    spike_gate_init(spike_gate_t *gate, int32_t threshold);
+uint8_t spike_gate_accept(spike_gate_t *gate, int32_t sample);
+void    slope_init(slope_t *slope, int32_t *buffer, uint16_t capacity);
+void    slope_push(slope_t *slope, int32_t sample);
+int32_t slope_estimate(slope_t *slope, int32_t scale);
+
+
+#endif
@@ -0,0 +1,69 @@
+#include <stdint.h>
+#include <string.h>
+#include "utils/histogram.h"
+#include "latency.h"
+
+
+static uint32_t elapsed(uint64_t from, uint64_t to);
+
+
+void latency_init(latency_t *latency) {
+    memset(latency, 0, sizeof(*latency));
+    latency->min = UINT32_MAX;
+}
+
+
+/*
+ *  The timestamps are taken by different tasks; a stage that appears to run backwards counts as zero
+ */
+void latency_add(latency_t *latency, uint64_t edge, uint64_t detection, uint64_t evaluation, uint64_t output) {
+    uint32_t total = elapsed(edge, output);
+
+    if (total < latency->min) {
+        latency->min = total;
+    }
+    if (total > latency->max) {
+        latency->max = total;
+    }
+
+    uint32_t detection_time = elapsed(edge, detection);
+    uint32_t dispatch_time  = elapsed(detection, evaluation);
+    uint32_t output_time    = elapsed(evaluation, output);
+
+    if (detection_time > latency->detection_max) {
+        latency->detection_max = detection_time;
+    }
+    if (dispatch_time > latency->dispatch_max) {
+        latency->dispatch_max = dispatch_time;
+    }
+    if (output_time > latency->output_max) {
+        latency->output_max = output_time;
+    }
+
+    latency->histogram[histogram_bin(total, LATENCY_HISTOGRAM_BINS)]++;
+    latency->count++;
+}
+
+
+void latency_summarize(const latency_t *latency, latency_summary_t *summary) {
+    summary->count         = latency->count;
+    summary->p50           = histogram_percentile(latency->histogram, LATENCY_HISTOGRAM_BINS, 500, latency->min,
+                                                  latency->max);
+    summary->p90           = histogram_percentile(latency->histogram, LATENCY_HISTOGRAM_BINS, 900, latency->min,
+                                                  latency->max);
+    summary->p99           = histogram_percentile(latency->histogram, LATENCY_HISTOGRAM_BINS, 990, latency->min,
+                                                  latency->max);
+    summary->max           = latency->max;
+    summary->detection_max = latency->detection_max;
+    summary->dispatch_max  = latency->dispatch_max;
+    summary->output_max    = latency->output_max;
+}
+
+
+static uint32_t elapsed(uint64_t from, uint64_t to) {
+    if (to <= from) {
+        return 0;
+    }
+    uint64_t difference = to - from;
+    return difference > UINT32_MAX ? UINT32_MAX : (uint32_t)difference;
+}
@@ -0,0 +1,55 @@
+#ifndef LATENCY_H_INCLUDED
+#define LATENCY_H_INCLUDED
+
+
+#include <stdint.h>
+
+
+#define LATENCY_HISTOGRAM_BINS 64
+
+
+typedef enum {
+    LATENCY_SOURCE_SIGNAL = 0,
+    LATENCY_SOURCE_PRESSURE,
+} latency_source_t;
+
+#define LATENCY_NUM_SOURCES 2
+
+
+/*
+ *  Latencies from a safety condition failing to the approval output being written, all times in microseconds.
+ *  The total is split in three stages: from the edge to its detection (debounce for the safety input, conversion and
+ *  filtering for the pressure), from the detection to the safety evaluation and from the evaluation to the output.
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+    uint32_t max;
+    uint32_t detection_max;
+    uint32_t dispatch_max;
+    uint32_t output_max;
+} latency_summary_t;
+
+
+/*
+ *  Accumulator of the latencies of one source since boot
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t detection_max;
+    uint32_t dispatch_max;
+    uint32_t output_max;
+    uint32_t histogram[LATENCY_HISTOGRAM_BINS];
+} latency_t;
+
+
+void latency_init(latency_t *latency);
+void latency_add(latency_t *latency, uint64_t edge, uint64_t detection, uint64_t evaluation, uint64_t output);
+void latency_summarize(const latency_t *latency, latency_summary_t *summary);
+
+
+#endif
@@ -1,11 +1,16 @@
 #include <sys/time.h>
 #include <assert.h>
+#include <stdatomic.h>
 #include "minion.h"
 #include "config/app_config.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "freertos/projdefs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "freertos/event_groups.h"
 #include "peripherals/hardwareprofile.h"
 #include "lightmodbus/base.h"
 #include "lightmodbus/lightmodbus.h"
@@ -25,22 +30,147 @@
 #include "config/app_config.h"
 #include "gel/serializer/serializer.h"
 #include "sensors.h"
+#include "capture.h"
+#include "filter.h"
+#include "profiler.h"
 
 
 #define HOLDING_REGISTER_MINIMUM_PRESSURE_MESSAGE EASYCONNECT_HOLDING_REGISTER_MESSAGE_1
 #define HOLDING_REGISTER_MAXIMUM_PRESSURE_MESSAGE                                                                      \
     (HOLDING_REGISTER_MINIMUM_PRESSURE_MESSAGE + EASYCONNECT_MESSAGE_NUM_REGISTERS)
-#define HOLDING_REGISTER_PRESSURE    EASYCONNECT_HOLDING_REGISTER_CUSTOM_START
-#define HOLDING_REGISTER_TEMPERATURE EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 1
-#define HOLDING_REGISTER_HUMIDITY    EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 2
+#define HOLDING_REGISTER_PRESSURE                 EASYCONNECT_HOLDING_REGISTER_CUSTOM_START
+#define HOLDING_REGISTER_TEMPERATURE              EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 1
+#define HOLDING_REGISTER_HUMIDITY                 EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 2
+#define HOLDING_REGISTER_PRESSURE_OSR             EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 3
+#define HOLDING_REGISTER_PRESSURE_WINDOW          EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 4
+#define HOLDING_REGISTER_PRESSURE_FILTER          EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 5
+#define HOLDING_REGISTER_TEMPERATURE_FILTER       EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 6
+#define HOLDING_REGISTER_HUMIDITY_FILTER          EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 7
+#define HOLDING_REGISTER_PRESSURE_REJECTED        EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 8
+#define HOLDING_REGISTER_CAPTURE_STATE            EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 9
+#define HOLDING_REGISTER_CAPTURE_COUNT            EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 10
+#define HOLDING_REGISTER_CAPTURE_TRIGGER          EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 11
+#define HOLDING_REGISTER_CAPTURE_PAGE             EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 12
+#define HOLDING_REGISTER_CAPTURE_DATA             EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 13
+#define HOLDING_REGISTER_TIMING                   EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 133
+#define HOLDING_REGISTER_PRESSURE_PERIOD          EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 165
+#define HOLDING_REGISTER_PRESSURE_OVERRUNS        EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 166
+#define HOLDING_REGISTER_SHTC3_OVERRUNS           EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 167
+#define HOLDING_REGISTER_PRESSURE_SLOPE           EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 168
+#define HOLDING_REGISTER_PRESSURE_SLOPE_ALARM     EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 169
+#define HOLDING_REGISTER_STATISTICS_WINDOW        EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 170
+#define HOLDING_REGISTER_STATISTICS_RESET_ON_READ EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 171
+#define HOLDING_REGISTER_STATISTICS               EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 172
+#define HOLDING_REGISTER_LATENCY                  EASYCONNECT_HOLDING_REGISTER_CUSTOM_START + 190
+
+// Each captured sample is timestamp (us), D1 and D2, two registers each, most significant word first
+#define CAPTURE_REGISTERS_PER_SAMPLE 6
+#define CAPTURE_SAMPLES_PER_PAGE     20
+#define CAPTURE_PAGE_REGISTERS       (CAPTURE_SAMPLES_PER_PAGE * CAPTURE_REGISTERS_PER_SAMPLE)
+
+// Timing statistics of each device: samples, rate (0.1 Hz), interval min, max, p50, p99 and conversion min, max (us),
+// two registers each, most significant word first
+#define TIMING_REGISTERS_PER_DEVICE 16
+#define TIMING_REGISTERS            (TIMING_REGISTERS_PER_DEVICE * SENSORS_NUM_DEVICES)
+
+// Statistics of each channel: sample count (two registers, most significant word first), min, max, mean and
+// standard deviation. Every request that reads any part of the block takes a new snapshot of all of it
+#define STATISTICS_REGISTERS_PER_CHANNEL 6
+#define STATISTICS_REGISTERS             (STATISTICS_REGISTERS_PER_CHANNEL * SENSORS_NUM_CHANNELS)
+
+// Approval latency of the safety input and of the pressure: count, p50, p90, p99, max and worst detection, dispatch
+// and output stages (us), two registers each, most significant word first
+#define LATENCY_REGISTERS_PER_SOURCE 16
+#define LATENCY_REGISTERS            (LATENCY_REGISTERS_PER_SOURCE * LATENCY_NUM_SOURCES)
+
+#define HOLDING_REGISTERS_NUM (HOLDING_REGISTER_LATENCY + LATENCY_REGISTERS)
+#define MAX_READ_REGISTERS    125     // Modbus limit for a single read request
+
+#define REGISTER_ACCESS_READ  0x01
+#define REGISTER_ACCESS_WRITE 0x02
+#define REGISTER_ACCESS_RW    (REGISTER_ACCESS_READ | REGISTER_ACCESS_WRITE)
+
+// Descriptor shared by the registers from `first` to `last`; reads and writes get the offset from `first`, `checker`
+// (optional) rejects a written value before anything of the request is written
+#define REGISTERS_CHECKED(first, last, rights, reader, writer, checker)                                                \
+    [(first) ... (last)] = {                                                                                           \
+        .access = (rights), .base = (first), .read = (reader), .write = (writer), .check = (checker)}
+#define REGISTERS(first, last, rights, reader, writer) REGISTERS_CHECKED(first, last, rights, reader, writer, NULL)
+#define REGISTER(index, rights, reader, writer)        REGISTERS(index, index, rights, reader, writer)
+#define REGISTER_CHECKED(index, rights, reader, writer, checker)                                                       \
+    REGISTERS_CHECKED(index, index, rights, reader, writer, checker)
+
+// Reader of a model field as it was when the request arrived
+#define SNAPSHOT_READER(field)                                                                                         \
+    static uint16_t read_##field(const model_snapshot_t *snapshot, uint16_t offset) {                                  \
+        return (uint16_t)snapshot->field;                                                                              \
+    }
+
+// Writer that saves the register to the configuration of the same name
+#define CONFIGURATION_WRITER(name)                                                                                     \
+    static void write_##name(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value) {                          \
+        if (configuration_save_##name(ctx->arg, value)) {                                                              \
+            ESP_LOGW(TAG, "Invalid " #name " %i", value);                                                              \
+        }                                                                                                              \
+    }
 
 
-static const char   *TAG = "Minion";
-ModbusSlave          minion;
-static unsigned long timestamp = 0;
+typedef struct {
+    uint8_t  access;
+    uint16_t base;     // First register sharing the descriptor
+    uint16_t (*read)(const model_snapshot_t *snapshot, uint16_t offset);
+    void (*write)(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value);
+    uint8_t (*check)(uint16_t value);
+} register_descriptor_t;
+
+
+static const char        *TAG = "Minion";
+ModbusSlave               minion;
+static TimerHandle_t      heartbeat_timer  = NULL;
+static EventGroupHandle_t heartbeat_events = NULL;
+static EventBits_t        heartbeat_bits   = 0;
+// Written by the heartbeat handler and by the timer callback, which must not block on the model mutex
+static atomic_uint        heartbeat_missing = 0;
+static uint16_t           capture_page     = 0;
+// Statistics as they were when the last request reading them arrived
+static statistics_summary_t statistics_block[SENSORS_NUM_CHANNELS] = {0};
+// Model state as it was when the request being served arrived; all read registers come from it
+static model_snapshot_t request_snapshot = {0};
 
 static ModbusError           register_callback(const ModbusSlave *status, const ModbusRegisterCallbackArgs *args,
                                                ModbusRegisterCallbackResult *result);
+static const register_descriptor_t *holding_register_lookup(uint16_t index);
+static void                  holding_registers_read(uint16_t first, uint16_t count, uint16_t *values);
+static LIGHTMODBUS_RET_ERROR read_holding_registers(ModbusSlave *minion, uint8_t function, const uint8_t *requestPDU,
+                                                    uint8_t requestLength);
+static uint16_t              read_firmware_version(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              read_class(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              read_serial_number(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              read_alarms(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              read_state(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              read_minimum_pressure_message(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              read_maximum_pressure_message(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              read_filter(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              read_pressure_rejected(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              read_capture_state(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              read_capture_count(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              read_capture_trigger(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              read_capture_page(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              read_overruns(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              read_pressure_slope(const model_snapshot_t *snapshot, uint16_t offset);
+static uint16_t              capture_register(const model_snapshot_t *snapshot, uint16_t index);
+static uint16_t              timing_register(const model_snapshot_t *snapshot, uint16_t index);
+static uint16_t              statistics_register(const model_snapshot_t *snapshot, uint16_t index);
+static void                  statistics_snapshot(const model_snapshot_t *snapshot);
+static uint16_t              latency_register(const model_snapshot_t *snapshot, uint16_t index);
+static void                  write_address(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value);
+static void                  write_class(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value);
+static void                  write_serial_number(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value);
+static void                  write_pressure_slope_alarm(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value);
+static void                  write_filter(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value);
+static uint8_t               filter_type_valid(uint16_t type);
+static void                  write_capture_state(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value);
+static void                  write_capture_page(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value);
 static ModbusError           exception_callback(const ModbusSlave *minion, uint8_t function, ModbusExceptionCode code);
 static LIGHTMODBUS_RET_ERROR initialization_function(ModbusSlave *minion, uint8_t function, const uint8_t *requestPDU,
                                                      uint8_t requestLength);
@@ -48,6 +178,10 @@ static LIGHTMODBUS_RET_ERROR set_datetime(ModbusSlave *minion, uint8_t function,
                                           uint8_t requestLength);
 static LIGHTMODBUS_RET_ERROR heartbeat_received(ModbusSlave *minion, uint8_t function, const uint8_t *requestPDU,
                                                 uint8_t requestLength);
+static void                  heartbeat_expired(TimerHandle_t timer);
+static void                  modbus_task(void *args);
+static void                  serve_request(easyconnect_interface_t *context, uint8_t *buffer, int len);
+static uint8_t               frame_is_for_us(uint16_t address, const uint8_t *buffer, int len);
 
 
 static const ModbusSlaveFunctionHandler custom_functions[] = {
@@ -58,7 +192,7 @@ static const ModbusSlaveFunctionHandler custom_functions[] = {
     {2, modbusParseRequest01020304},
 #endif
 #if defined(LIGHTMODBUS_F03S) || defined(LIGHTMODBUS_SLAVE_FULL)
-    {3, modbusParseRequest01020304},
+    {3, read_holding_registers},
 #endif
 #if defined(LIGHTMODBUS_F04S) || defined(LIGHTMODBUS_SLAVE_FULL)
     {4, modbusParseRequest01020304},
@@ -90,6 +224,80 @@ static const ModbusSlaveFunctionHandler custom_functions[] = {
 };
 
 
+SNAPSHOT_READER(address);
+SNAPSHOT_READER(pressure);
+SNAPSHOT_READER(temperature);
+SNAPSHOT_READER(humidity);
+SNAPSHOT_READER(pressure_osr);
+SNAPSHOT_READER(pressure_window);
+SNAPSHOT_READER(pressure_period);
+SNAPSHOT_READER(pressure_slope_alarm);
+SNAPSHOT_READER(statistics_window);
+SNAPSHOT_READER(statistics_reset_on_read);
+
+CONFIGURATION_WRITER(pressure_osr);
+CONFIGURATION_WRITER(pressure_window);
+CONFIGURATION_WRITER(pressure_period);
+CONFIGURATION_WRITER(statistics_window);
+CONFIGURATION_WRITER(statistics_reset_on_read);
+
+
+/*
+ *  Holding register map, indexed by register address. Registers without an entry read as 0 and refuse writes; the
+ *  LOGS block is not implemented and stays unmapped
+ */
+static const register_descriptor_t holding_registers[HOLDING_REGISTERS_NUM] = {
+    REGISTER(EASYCONNECT_HOLDING_REGISTER_ADDRESS, REGISTER_ACCESS_RW, read_address, write_address),
+    REGISTER(EASYCONNECT_HOLDING_REGISTER_FIRMWARE_VERSION, REGISTER_ACCESS_READ, read_firmware_version, NULL),
+    REGISTER_CHECKED(EASYCONNECT_HOLDING_REGISTER_CLASS, REGISTER_ACCESS_RW, read_class, write_class,
+                     model_is_class_valid),
+    REGISTERS(EASYCONNECT_HOLDING_REGISTER_SERIAL_NUMBER_1, EASYCONNECT_HOLDING_REGISTER_SERIAL_NUMBER_2,
+              REGISTER_ACCESS_RW, read_serial_number, write_serial_number),
+    REGISTER(EASYCONNECT_HOLDING_REGISTER_ALARMS, REGISTER_ACCESS_READ, read_alarms, NULL),
+    // Writes are accepted for compatibility with the masters that clear it, but have no effect
+    REGISTER(EASYCONNECT_HOLDING_REGISTER_STATE, REGISTER_ACCESS_RW, read_state, NULL),
+    REGISTERS(HOLDING_REGISTER_MINIMUM_PRESSURE_MESSAGE, HOLDING_REGISTER_MAXIMUM_PRESSURE_MESSAGE - 1,
+              REGISTER_ACCESS_READ, read_minimum_pressure_message, NULL),
+    REGISTERS(HOLDING_REGISTER_MAXIMUM_PRESSURE_MESSAGE,
+              HOLDING_REGISTER_MAXIMUM_PRESSURE_MESSAGE + EASYCONNECT_MESSAGE_NUM_REGISTERS - 1, REGISTER_ACCESS_READ,
+              read_maximum_pressure_message, NULL),
+    REGISTER(HOLDING_REGISTER_PRESSURE, REGISTER_ACCESS_READ, read_pressure, NULL),
+    REGISTER(HOLDING_REGISTER_TEMPERATURE, REGISTER_ACCESS_READ, read_temperature, NULL),
+    REGISTER(HOLDING_REGISTER_HUMIDITY, REGISTER_ACCESS_READ, read_humidity, NULL),
+    REGISTER_CHECKED(HOLDING_REGISTER_PRESSURE_OSR, REGISTER_ACCESS_RW, read_pressure_osr, write_pressure_osr,
+                     model_is_pressure_osr_valid),
+    REGISTER_CHECKED(HOLDING_REGISTER_PRESSURE_WINDOW, REGISTER_ACCESS_RW, read_pressure_window, write_pressure_window,
+                     model_is_pressure_window_valid),
+    REGISTERS_CHECKED(HOLDING_REGISTER_PRESSURE_FILTER, HOLDING_REGISTER_HUMIDITY_FILTER, REGISTER_ACCESS_RW,
+                      read_filter, write_filter, filter_type_valid),
+    REGISTER(HOLDING_REGISTER_PRESSURE_REJECTED, REGISTER_ACCESS_READ, read_pressure_rejected, NULL),
+    REGISTER(HOLDING_REGISTER_CAPTURE_STATE, REGISTER_ACCESS_RW, read_capture_state, write_capture_state),
+    REGISTER(HOLDING_REGISTER_CAPTURE_COUNT, REGISTER_ACCESS_READ, read_capture_count, NULL),
+    REGISTER(HOLDING_REGISTER_CAPTURE_TRIGGER, REGISTER_ACCESS_READ, read_capture_trigger, NULL),
+    REGISTER(HOLDING_REGISTER_CAPTURE_PAGE, REGISTER_ACCESS_RW, read_capture_page, write_capture_page),
+    REGISTERS(HOLDING_REGISTER_CAPTURE_DATA, HOLDING_REGISTER_CAPTURE_DATA + CAPTURE_PAGE_REGISTERS - 1,
+              REGISTER_ACCESS_READ, capture_register, NULL),
+    REGISTERS(HOLDING_REGISTER_TIMING, HOLDING_REGISTER_TIMING + TIMING_REGISTERS - 1, REGISTER_ACCESS_READ,
+              timing_register, NULL),
+    REGISTER_CHECKED(HOLDING_REGISTER_PRESSURE_PERIOD, REGISTER_ACCESS_RW, read_pressure_period, write_pressure_period,
+                     model_is_pressure_period_valid),
+    // One register per device, in the order of `sensors_device_t`
+    REGISTERS(HOLDING_REGISTER_PRESSURE_OVERRUNS, HOLDING_REGISTER_SHTC3_OVERRUNS, REGISTER_ACCESS_READ, read_overruns,
+              NULL),
+    REGISTER(HOLDING_REGISTER_PRESSURE_SLOPE, REGISTER_ACCESS_READ, read_pressure_slope, NULL),
+    REGISTER(HOLDING_REGISTER_PRESSURE_SLOPE_ALARM, REGISTER_ACCESS_RW, read_pressure_slope_alarm,
+             write_pressure_slope_alarm),
+    REGISTER_CHECKED(HOLDING_REGISTER_STATISTICS_WINDOW, REGISTER_ACCESS_RW, read_statistics_window,
+                     write_statistics_window, model_is_statistics_window_valid),
+    REGISTER_CHECKED(HOLDING_REGISTER_STATISTICS_RESET_ON_READ, REGISTER_ACCESS_RW, read_statistics_reset_on_read,
+                     write_statistics_reset_on_read, model_is_statistics_reset_on_read_valid),
+    REGISTERS(HOLDING_REGISTER_STATISTICS, HOLDING_REGISTER_STATISTICS + STATISTICS_REGISTERS - 1, REGISTER_ACCESS_READ,
+              statistics_register, NULL),
+    REGISTERS(HOLDING_REGISTER_LATENCY, HOLDING_REGISTER_LATENCY + LATENCY_REGISTERS - 1, REGISTER_ACCESS_READ,
+              latency_register, NULL),
+};
+
+
 void minion_init(easyconnect_interface_t *context) {
     ModbusErrorInfo err;
     err = modbusSlaveInit(&minion,
@@ -105,40 +313,101 @@ void minion_init(easyconnect_interface_t *context) {
 
     modbusSlaveSetUserPointer(&minion, context);
 
-    timestamp = get_millis();
+    // One shot timer restarted by every heartbeat, so a missing master is noticed without polling
+    static StaticTimer_t timer_buffer;
+    heartbeat_timer = xTimerCreateStatic("timerHeartbeat", pdMS_TO_TICKS(EASYCONNECT_HEARTBEAT_TIMEOUT), pdFALSE,
+                                         context, heartbeat_expired, &timer_buffer);
+    xTimerStart(heartbeat_timer, portMAX_DELAY);
+
+    static StaticTask_t task_buffer;
+    static StackType_t  task_stack[APP_CONFIG_BASE_TASK_STACK_SIZE * 6];
+    xTaskCreateStatic(modbus_task, "Modbus", sizeof(task_stack) / sizeof(StackType_t), context,
+                      APP_CONFIG_MODBUS_TASK_PRIORITY, task_stack, &task_buffer);
 }
 
 
-void minion_manage(void) {
-    uint8_t buffer[256] = {0};
-    int     len         = rs485_read(buffer, 256);
+/*
+ *  `bits` are set in `event_group` when the heartbeat timeout expires or a heartbeat arrives
+ */
+void minion_set_heartbeat_notification(EventGroupHandle_t event_group, EventBits_t bits) {
+    heartbeat_bits   = bits;
+    heartbeat_events = event_group;
+}
 
-    easyconnect_interface_t *context = modbusSlaveGetUserPointer(&minion);
 
-    if (len > 0) {
-        // ESP_LOG_BUFFER_HEX(TAG, buffer, len);
+/*
+ *  Whether the heartbeat timed out; whoever owns the model copies it to `missing_heartbeat`
+ */
+uint8_t minion_is_heartbeat_missing(void) {
+    return (uint8_t)atomic_load(&heartbeat_missing);
+}
 
-        ModbusErrorInfo err;
-        err = modbusParseRequestRTU(&minion, context->get_address(context->arg), buffer, len);
 
-        if (modbusIsOk(err)) {
-            size_t rlen = modbusSlaveGetResponseLength(&minion);
-            if (rlen > 0) {
-                rs485_write((uint8_t *)modbusSlaveGetResponse(&minion), rlen);
-            } else {
-                ESP_LOGD(TAG, "Empty response");
-            }
-        } else if (err.error != MODBUS_ERROR_ADDRESS) {
-            ESP_LOGW(TAG, "Invalid request with source %i and error %i", err.source, err.error);
-            ESP_LOG_BUFFER_HEX(TAG, buffer, len);
+/*
+ *  Sleeps until the UART driver hands over a complete frame, then serves it right away
+ */
+static void modbus_task(void *args) {
+    easyconnect_interface_t *context = args;
+    static uint8_t           buffer[RS485_MAX_FRAME_SIZE];
+
+    for (;;) {
+        uint64_t received = 0;
+        int      len      = rs485_read_frame(buffer, sizeof(buffer), &received, portMAX_DELAY);
+
+        if (len > 0) {
+            // Hand over from the end of the frame to this task
+            PROFILER_RECORD_SINCE(PROFILER_STAGE_UART_READ, received);
+            serve_request(context, buffer, len);
+            PROFILER_RECORD_SINCE(PROFILER_STAGE_REQUEST_TO_RESPONSE, received);
         }
     }
 
-    if (is_expired(timestamp, get_millis(), EASYCONNECT_HEARTBEAT_TIMEOUT)) {
-        if (model_get_missing_heartbeat(context->arg) == 0) {
-            model_set_missing_heartbeat(context->arg, 1);
+    vTaskDelete(NULL);
+}
+
+
+static void serve_request(easyconnect_interface_t *context, uint8_t *buffer, int len) {
+    // ESP_LOG_BUFFER_HEX(TAG, buffer, len);
+
+    // Most of the traffic on a shared bus is for other devices: skip it before the snapshot, the CRC and the parse
+    if (!frame_is_for_us(model_get_published_address(context->arg), buffer, len)) {
+        return;
+    }
+
+    // One consistent view of the model for the whole request, without taking the model mutex per register
+    model_get_snapshot(context->arg, &request_snapshot);
+
+    ModbusErrorInfo err;
+    PROFILER_BEGIN(PROFILER_STAGE_RTU_PARSE);
+    err = modbusParseRequestRTU(&minion, request_snapshot.address, buffer, len);
+    PROFILER_END(PROFILER_STAGE_RTU_PARSE);
+
+    if (modbusIsOk(err)) {
+        size_t rlen = modbusSlaveGetResponseLength(&minion);
+        if (rlen > 0) {
+            PROFILER_BEGIN(PROFILER_STAGE_RESPONSE_WRITE);
+            rs485_write((uint8_t *)modbusSlaveGetResponse(&minion), rlen);
+            PROFILER_END(PROFILER_STAGE_RESPONSE_WRITE);
+        } else {
+            ESP_LOGD(TAG, "Empty response");
         }
+    } else if (err.error != MODBUS_ERROR_ADDRESS) {
+        ESP_LOGW(TAG, "Invalid request with source %i and error %i", err.source, err.error);
+        ESP_LOG_BUFFER_HEX(TAG, buffer, len);
+    }
+}
+
+
+/*
+ *  Only looks at the address, the same check the parser would make after the CRC; broadcasts always go through
+ */
+static uint8_t frame_is_for_us(uint16_t address, const uint8_t *buffer, int len) {
+    if (len < 1) {
+        // Nothing to tell, let the parser report it
+        return 1;
     }
+
+    return buffer[0] == address || buffer[0] == 0;
 }
 
 
@@ -147,164 +416,55 @@ ModbusError register_callback(const ModbusSlave *status, const ModbusRegisterCal
 
     easyconnect_interface_t *ctx = modbusSlaveGetUserPointer(status);
     result->value                = 0;
+    result->exceptionCode        = MODBUS_EXCEP_NONE;
 
-    switch (args->query) {
-        // R/W access check
-        case MODBUS_REGQ_R_CHECK:
-            result->exceptionCode = MODBUS_EXCEP_NONE;
-            break;
+    switch (args->type) {
+        case MODBUS_HOLDING_REGISTER: {
+            const register_descriptor_t *descriptor = holding_register_lookup(args->index);
 
-        case MODBUS_REGQ_W_CHECK:
-            result->exceptionCode = MODBUS_EXCEP_NONE;
-
-            switch (args->type) {
-                case MODBUS_HOLDING_REGISTER: {
-                    switch (args->index) {
-                        case EASYCONNECT_HOLDING_REGISTER_ADDRESS:
-                        case EASYCONNECT_HOLDING_REGISTER_CLASS:
-                        case EASYCONNECT_HOLDING_REGISTER_SERIAL_NUMBER_1:
-                        case EASYCONNECT_HOLDING_REGISTER_SERIAL_NUMBER_2:
-                        case EASYCONNECT_HOLDING_REGISTER_STATE:
-                            break;
-
-                        default:
-                            result->exceptionCode = MODBUS_EXCEP_ILLEGAL_FUNCTION;
-                            break;
-                    }
-                    break;
-                }
-                case MODBUS_INPUT_REGISTER:
-                    result->exceptionCode = MODBUS_EXCEP_ILLEGAL_FUNCTION;
+            switch (args->query) {
+                // Unmapped registers read as 0, so masters can poll across the gaps of the map
+                case MODBUS_REGQ_R_CHECK:
                     break;
-                case MODBUS_DISCRETE_INPUT:
-                    result->exceptionCode = MODBUS_EXCEP_ILLEGAL_FUNCTION;
-                    break;
-                default:
-                    break;
-            }
-            break;
 
-        // Read register
-        case MODBUS_REGQ_R:
-            switch (args->type) {
-                case MODBUS_HOLDING_REGISTER: {
-                    switch (args->index) {
-                        case EASYCONNECT_HOLDING_REGISTER_ADDRESS:
-                            result->value = ctx->get_address(ctx->arg);
-                            break;
-
-                        case EASYCONNECT_HOLDING_REGISTER_FIRMWARE_VERSION:
-                            result->value = EASYCONNECT_FIRMWARE_VERSION(APP_CONFIG_FIRMWARE_VERSION_MAJOR,
-                                                                         APP_CONFIG_FIRMWARE_VERSION_MINOR,
-                                                                         APP_CONFIG_FIRMWARE_VERSION_PATCH);
-                            break;
-
-                        case EASYCONNECT_HOLDING_REGISTER_CLASS:
-                            result->value = ctx->get_class(ctx->arg);
-                            break;
-
-                        case EASYCONNECT_HOLDING_REGISTER_SERIAL_NUMBER_1:
-                            result->value = (ctx->get_serial_number(ctx->arg) >> 16) & 0xFFFF;
-                            break;
-
-                        case EASYCONNECT_HOLDING_REGISTER_SERIAL_NUMBER_2:
-                            result->value = ctx->get_serial_number(ctx->arg) & 0xFFFF;
-                            break;
-
-                        case EASYCONNECT_HOLDING_REGISTER_ALARMS:
-                            result->value =
-                                (safety_signal_ok(ctx->arg) == 0) | ((safety_pressure_ok(ctx->arg) == 0) << 1);
-                            break;
-
-                        case EASYCONNECT_HOLDING_REGISTER_STATE:
-                            result->value = sensors_get_errors();
-                            break;
-
-                        case EASYCONNECT_HOLDING_REGISTER_LOGS_COUNTER:
-                            result->value = 0;
-                            break;
-
-                        case EASYCONNECT_HOLDING_REGISTER_LOGS ... EASYCONNECT_HOLDING_REGISTER_MESSAGE_1 - 1: {
-                            result->value = 0;
-                            break;
-                        }
-
-                        case HOLDING_REGISTER_MINIMUM_PRESSURE_MESSAGE ... HOLDING_REGISTER_MAXIMUM_PRESSURE_MESSAGE -
-                            1: {
-                            char msg[EASYCONNECT_MESSAGE_SIZE + 1] = {0};
-                            model_get_minimum_pressure_message(ctx->arg, msg);
-                            size_t i      = args->index - HOLDING_REGISTER_MINIMUM_PRESSURE_MESSAGE;
-                            result->value = msg[i * 2] << 8 | msg[i * 2 + 1];
-                            break;
-                        }
-
-                        case HOLDING_REGISTER_MAXIMUM_PRESSURE_MESSAGE ... HOLDING_REGISTER_MAXIMUM_PRESSURE_MESSAGE +
-                            EASYCONNECT_MESSAGE_NUM_REGISTERS - 1: {
-                            char msg[EASYCONNECT_MESSAGE_SIZE + 1] = {0};
-                            model_get_maximum_pressure_message(ctx->arg, msg);
-                            size_t i      = args->index - HOLDING_REGISTER_MAXIMUM_PRESSURE_MESSAGE;
-                            result->value = msg[i * 2] << 8 | msg[i * 2 + 1];
-                            break;
-                        }
-
-                        case HOLDING_REGISTER_PRESSURE:
-                            result->value = model_get_pressure(ctx->arg);
-                            break;
-
-                        case HOLDING_REGISTER_TEMPERATURE:
-                            result->value = model_get_temperature(ctx->arg);
-                            break;
-
-                        case HOLDING_REGISTER_HUMIDITY:
-                            result->value = model_get_humidity(ctx->arg);
-                            break;
+                case MODBUS_REGQ_W_CHECK:
+                    if ((descriptor->access & REGISTER_ACCESS_WRITE) == 0) {
+                        result->exceptionCode = MODBUS_EXCEP_ILLEGAL_FUNCTION;
+                    } else if (descriptor->check != NULL && !descriptor->check(args->value)) {
+                        result->exceptionCode = MODBUS_EXCEP_ILLEGAL_VALUE;
                     }
                     break;
-                }
-                case MODBUS_INPUT_REGISTER:
-                    break;
-                case MODBUS_COIL:
-                    result->value = digout_get();
-                    break;
-                case MODBUS_DISCRETE_INPUT:
-                    result->value = digin_get(args->index);
+
+                case MODBUS_REGQ_R:
+                    holding_registers_read(args->index, 1, &result->value);
                     break;
-            }
-            break;
 
-        // Write register
-        case MODBUS_REGQ_W:
-            switch (args->type) {
-                case MODBUS_HOLDING_REGISTER: {
-                    switch (args->index) {
-                        case EASYCONNECT_HOLDING_REGISTER_ADDRESS:
-                            ctx->save_address(ctx->arg, args->value);
-                            break;
-                        case EASYCONNECT_HOLDING_REGISTER_CLASS:
-                            ctx->save_class(ctx->arg, args->value);
-                            break;
-                        case EASYCONNECT_HOLDING_REGISTER_SERIAL_NUMBER_1: {
-                            uint32_t current_serial_number = ctx->get_serial_number(ctx->arg);
-                            ctx->save_serial_number(ctx->arg, (args->value << 16) | (current_serial_number & 0xFFFF));
-                            break;
-                        }
-                        case EASYCONNECT_HOLDING_REGISTER_SERIAL_NUMBER_2: {
-                            uint32_t current_serial_number = ctx->get_serial_number(ctx->arg);
-                            ctx->save_serial_number(ctx->arg, args->value | (current_serial_number & 0xFFFF0000));
-                            break;
-                        }
+                case MODBUS_REGQ_W:
+                    if (descriptor->write != NULL) {
+                        descriptor->write(ctx, args->index - descriptor->base, args->value);
                     }
                     break;
-                }
+            }
+            break;
+        }
 
-                case MODBUS_COIL:
-                    break;
+        case MODBUS_INPUT_REGISTER:
+            if (args->query == MODBUS_REGQ_W_CHECK) {
+                result->exceptionCode = MODBUS_EXCEP_ILLEGAL_FUNCTION;
+            }
+            break;
 
-                case MODBUS_INPUT_REGISTER:
-                    break;
+        case MODBUS_COIL:
+            if (args->query == MODBUS_REGQ_R) {
+                result->value = digout_get();
+            }
+            break;
 
-                default:
-                    break;
+        case MODBUS_DISCRETE_INPUT:
+            if (args->query == MODBUS_REGQ_W_CHECK) {
+                result->exceptionCode = MODBUS_EXCEP_ILLEGAL_FUNCTION;
+            } else if (args->query == MODBUS_REGQ_R) {
+                result->value = digin_get(args->index);
             }
             break;
     }
@@ -314,6 +474,302 @@ ModbusError register_callback(const ModbusSlave *status, const ModbusRegisterCal
 }
 
 
+/*
+ *  Descriptor of holding register `index`; registers outside of the map get an entry without access rights
+ */
+static const register_descriptor_t *holding_register_lookup(uint16_t index) {
+    static const register_descriptor_t unmapped = {0};
+    return index < HOLDING_REGISTERS_NUM ? &holding_registers[index] : &unmapped;
+}
+
+
+/*
+ *  Bulk read entry point: fills `values` with `count` registers starting from `first` in a single pass over the
+ *  table, all taken from the request snapshot
+ */
+static void holding_registers_read(uint16_t first, uint16_t count, uint16_t *values) {
+    if (first < HOLDING_REGISTER_STATISTICS + STATISTICS_REGISTERS && first + count > HOLDING_REGISTER_STATISTICS) {
+        statistics_snapshot(&request_snapshot);
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t                     index      = first + i;
+        const register_descriptor_t *descriptor = holding_register_lookup(index);
+
+        if (descriptor->access & REGISTER_ACCESS_READ) {
+            values[i] = descriptor->read(&request_snapshot, index - descriptor->base);
+        } else {
+            values[i] = 0;
+        }
+    }
+}
+
+
+/*
+ *  Function 3 served straight from the register table, without the two callback round trips per register of the
+ *  generic lightmodbus parser
+ */
+static LIGHTMODBUS_RET_ERROR read_holding_registers(ModbusSlave *minion, uint8_t function, const uint8_t *requestPDU,
+                                                    uint8_t requestLength) {
+    if (requestLength != 5) {
+        return modbusBuildException(minion, function, MODBUS_EXCEP_ILLEGAL_VALUE);
+    }
+
+    uint16_t first = modbusRBE(&requestPDU[1]);
+    uint16_t count = modbusRBE(&requestPDU[3]);
+
+    if (count == 0 || count > MAX_READ_REGISTERS) {
+        return modbusBuildException(minion, function, MODBUS_EXCEP_ILLEGAL_VALUE);
+    }
+    if (modbusCheckRangeU16(first, count)) {
+        return modbusBuildException(minion, function, MODBUS_EXCEP_ILLEGAL_ADDRESS);
+    }
+
+    ModbusErrorInfo err = modbusSlaveAllocateResponse(minion, 2 + count * 2);
+    if (!modbusIsOk(err)) {
+        return err;
+    }
+
+    uint16_t values[MAX_READ_REGISTERS] = {0};
+    holding_registers_read(first, count, values);
+
+    minion->response.pdu[0] = function;
+    minion->response.pdu[1] = count * 2;
+    for (uint16_t i = 0; i < count; i++) {
+        modbusWBE(&minion->response.pdu[2 + i * 2], values[i]);
+    }
+
+    return MODBUS_NO_ERROR();
+}
+
+
+static uint16_t read_firmware_version(const model_snapshot_t *snapshot, uint16_t offset) {
+    return EASYCONNECT_FIRMWARE_VERSION(APP_CONFIG_FIRMWARE_VERSION_MAJOR, APP_CONFIG_FIRMWARE_VERSION_MINOR,
+                                        APP_CONFIG_FIRMWARE_VERSION_PATCH);
+}
+
+
+static uint16_t read_class(const model_snapshot_t *snapshot, uint16_t offset) {
+    return model_snapshot_get_class(snapshot);
+}
+
+
+static uint16_t read_serial_number(const model_snapshot_t *snapshot, uint16_t offset) {
+    return offset == 0 ? (snapshot->serial_number >> 16) & 0xFFFF : snapshot->serial_number & 0xFFFF;
+}
+
+
+static uint16_t read_alarms(const model_snapshot_t *snapshot, uint16_t offset) {
+    // Same conditions the safety task last used to drive the approval output
+    uint8_t status = safety_get_status();
+    return ((status & SAFETY_STATUS_SIGNAL_OK) == 0) | (((status & SAFETY_STATUS_PRESSURE_OK) == 0) << 1) |
+           ((safety_pressure_slope_ok(snapshot) == 0) << 2);
+}
+
+
+static uint16_t read_state(const model_snapshot_t *snapshot, uint16_t offset) {
+    return sensors_get_errors();
+}
+
+
+static uint16_t read_minimum_pressure_message(const model_snapshot_t *snapshot, uint16_t offset) {
+    return snapshot->minimum_pressure_message_registers[offset];
+}
+
+
+static uint16_t read_maximum_pressure_message(const model_snapshot_t *snapshot, uint16_t offset) {
+    return snapshot->maximum_pressure_message_registers[offset];
+}
+
+
+/*
+ *  Filter of channel `offset`, the filter registers follow the order of `sensors_channel_t`
+ */
+static uint16_t read_filter(const model_snapshot_t *snapshot, uint16_t offset) {
+    uint8_t filters[SENSORS_NUM_CHANNELS] = {
+        [SENSORS_CHANNEL_PRESSURE]    = snapshot->pressure_filter,
+        [SENSORS_CHANNEL_TEMPERATURE] = snapshot->temperature_filter,
+        [SENSORS_CHANNEL_HUMIDITY]    = snapshot->humidity_filter,
+    };
+    return filters[offset];
+}
+
+
+static uint16_t read_pressure_rejected(const model_snapshot_t *snapshot, uint16_t offset) {
+    return sensors_get_pressure_rejected_samples();
+}
+
+
+static uint16_t read_capture_state(const model_snapshot_t *snapshot, uint16_t offset) {
+    return capture_get_state();
+}
+
+
+static uint16_t read_capture_count(const model_snapshot_t *snapshot, uint16_t offset) {
+    return capture_get_count();
+}
+
+
+static uint16_t read_capture_trigger(const model_snapshot_t *snapshot, uint16_t offset) {
+    return capture_get_trigger_position();
+}
+
+
+static uint16_t read_capture_page(const model_snapshot_t *snapshot, uint16_t offset) {
+    return capture_page;
+}
+
+
+/*
+ *  Overruns of device `offset`, saturated to a single register
+ */
+static uint16_t read_overruns(const model_snapshot_t *snapshot, uint16_t offset) {
+    uint32_t overruns = sensors_get_overruns(offset);
+    return overruns > UINT16_MAX ? UINT16_MAX : overruns;
+}
+
+
+static uint16_t read_pressure_slope(const model_snapshot_t *snapshot, uint16_t offset) {
+    return (uint16_t)sensors_get_pressure_slope();
+}
+
+
+static void write_address(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value) {
+    ctx->save_address(ctx->arg, value);
+}
+
+
+static void write_class(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value) {
+    if (ctx->save_class(ctx->arg, value)) {
+        ESP_LOGW(TAG, "Invalid class %i", value);
+    }
+}
+
+
+/*
+ *  Each half of the serial number is merged with the other as currently saved, so a two register write of the whole
+ *  number lands correctly
+ */
+static void write_serial_number(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value) {
+    uint32_t current_serial_number = ctx->get_serial_number(ctx->arg);
+    if (offset == 0) {
+        ctx->save_serial_number(ctx->arg, ((uint32_t)value << 16) | (current_serial_number & 0xFFFF));
+    } else {
+        ctx->save_serial_number(ctx->arg, value | (current_serial_number & 0xFFFF0000));
+    }
+}
+
+
+static void write_pressure_slope_alarm(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value) {
+    // Any slope is a valid alarm threshold
+    configuration_save_pressure_slope_alarm(ctx->arg, value);
+}
+
+
+static void write_filter(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value) {
+    if (configuration_save_filter(ctx->arg, offset, value)) {
+        ESP_LOGW(TAG, "Invalid filter %i", value);
+    }
+}
+
+
+static uint8_t filter_type_valid(uint16_t type) {
+    return type < FILTER_TYPE_NUM;
+}
+
+
+static void write_capture_state(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value) {
+    // Any write discards the frozen capture and starts recording again
+    capture_arm();
+}
+
+
+static void write_capture_page(easyconnect_interface_t *ctx, uint16_t offset, uint16_t value) {
+    capture_page = value;
+}
+
+
+/*
+ *  Register `index` of the selected capture page; samples past the end of the capture read as 0
+ */
+static uint16_t capture_register(const model_snapshot_t *snapshot, uint16_t index) {
+    capture_sample_t sample = {0};
+    size_t           first  = (size_t)capture_page * CAPTURE_SAMPLES_PER_PAGE + index / CAPTURE_REGISTERS_PER_SAMPLE;
+
+    if (capture_read(first, &sample, 1) == 0) {
+        return 0;
+    }
+
+    uint32_t values[] = {sample.timestamp, sample.pressure_adc, sample.temperature_adc};
+    uint32_t value    = values[(index % CAPTURE_REGISTERS_PER_SAMPLE) / 2];
+    return (index % 2) == 0 ? (value >> 16) & 0xFFFF : value & 0xFFFF;
+}
+
+
+/*
+ *  Register `index` of the timing statistics block
+ */
+static uint16_t timing_register(const model_snapshot_t *snapshot, uint16_t index) {
+    timing_summary_t summary = {0};
+    sensors_get_timing(index / TIMING_REGISTERS_PER_DEVICE, &summary);
+
+    uint32_t values[] = {
+        summary.samples,      summary.rate,         summary.interval_min,   summary.interval_max,
+        summary.interval_p50, summary.interval_p99, summary.conversion_min, summary.conversion_max,
+    };
+    uint32_t value = values[(index % TIMING_REGISTERS_PER_DEVICE) / 2];
+    return (index % 2) == 0 ? (value >> 16) & 0xFFFF : value & 0xFFFF;
+}
+
+
+static uint16_t latency_register(const model_snapshot_t *snapshot, uint16_t index) {
+    latency_summary_t summary = {0};
+    safety_get_latency(index / LATENCY_REGISTERS_PER_SOURCE, &summary);
+
+    uint32_t values[] = {
+        summary.count, summary.p50,           summary.p90,          summary.p99,
+        summary.max,   summary.detection_max, summary.dispatch_max, summary.output_max,
+    };
+    uint32_t value = values[(index % LATENCY_REGISTERS_PER_SOURCE) / 2];
+    return (index % 2) == 0 ? (value >> 16) & 0xFFFF : value & 0xFFFF;
+}
+
+
+/*
+ *  Takes the statistics served by the current request; in reset-on-read mode it also restarts the accumulation
+ */
+static void statistics_snapshot(const model_snapshot_t *snapshot) {
+    for (sensors_channel_t channel = 0; channel < SENSORS_NUM_CHANNELS; channel++) {
+        sensors_get_statistics(channel, &statistics_block[channel]);
+    }
+    if (snapshot->statistics_reset_on_read) {
+        sensors_reset_statistics();
+    }
+}
+
+
+/*
+ *  Register `index` of the statistics snapshot taken for the current request
+ */
+static uint16_t statistics_register(const model_snapshot_t *snapshot, uint16_t index) {
+    statistics_summary_t *summary = &statistics_block[index / STATISTICS_REGISTERS_PER_CHANNEL];
+    switch (index % STATISTICS_REGISTERS_PER_CHANNEL) {
+        case 0:
+            return (summary->count >> 16) & 0xFFFF;
+        case 1:
+            return summary->count & 0xFFFF;
+        case 2:
+            return (uint16_t)summary->min;
+        case 3:
+            return (uint16_t)summary->max;
+        case 4:
+            return (uint16_t)summary->mean;
+        default:
+            return (uint16_t)summary->stddev;
+    }
+}
+
+
 static ModbusError exception_callback(const ModbusSlave *minion, uint8_t function, ModbusExceptionCode code) {
     ESP_LOGI(TAG, "Slave reports an exception %d (function %d)\n", code, function);
     // Always return MODBUS_OK
@@ -329,15 +785,29 @@ static LIGHTMODBUS_RET_ERROR initialization_function(ModbusSlave *minion, uint8_
 
 static LIGHTMODBUS_RET_ERROR heartbeat_received(ModbusSlave *minion, uint8_t function, const uint8_t *requestPDU,
                                                 uint8_t requestLength) {
-    easyconnect_interface_t *ctx = modbusSlaveGetUserPointer(minion);
     ESP_LOGI(TAG, "Heartbeat");
 
-    timestamp = get_millis();
-    model_set_missing_heartbeat(ctx->arg, 0);
+    xTimerReset(heartbeat_timer, 0);
+    if (atomic_exchange(&heartbeat_missing, 0) && heartbeat_events != NULL) {
+        xEventGroupSetBits(heartbeat_events, heartbeat_bits);
+    }
     return MODBUS_NO_ERROR();
 }
 
 
+/*
+ *  Runs in the timer service task, so it only raises the flag: blocking here would stall every other software timer
+ */
+static void heartbeat_expired(TimerHandle_t timer) {
+    (void)timer;
+    atomic_store(&heartbeat_missing, 1);
+
+    if (heartbeat_events != NULL) {
+        xEventGroupSetBits(heartbeat_events, heartbeat_bits);
+    }
+}
+
+
 static LIGHTMODBUS_RET_ERROR set_datetime(ModbusSlave *minion, uint8_t function, const uint8_t *requestPDU,
                                           uint8_t requestLength) {
     // Check request length
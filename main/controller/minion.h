@@ -4,9 +4,12 @@
 
 #include "model/model.h"
 #include "easyconnect.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
 
 
-void minion_init(easyconnect_interface_t *context);
-void minion_manage(void);
+void    minion_init(easyconnect_interface_t *context);
+void    minion_set_heartbeat_notification(EventGroupHandle_t event_group, EventBits_t bits);
+uint8_t minion_is_heartbeat_missing(void);
 
 #endif
\ No newline at end of file
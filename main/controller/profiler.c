@@ -0,0 +1,65 @@
+#include <stdatomic.h>
+#include <string.h>
+#include "profiler.h"
+
+
+#ifdef CONFIG_EASYCONNECT_PROFILER
+
+
+// Upper limits (us) of all buckets but the last one
+static const uint32_t bucket_limits[PROFILER_NUM_BUCKETS - 1] = {
+    10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000,
+};
+
+
+// Each stage is only recorded by one task, the others just read it
+static profiler_histogram_t histograms[PROFILER_NUM_STAGES] = {0};
+// Resets are applied by the recording task on its next sample, one bit per stage
+static atomic_uint reset_requests = 0;
+
+
+void profiler_record(profiler_stage_t stage, uint64_t duration) {
+    profiler_histogram_t *histogram = &histograms[stage];
+
+    if (atomic_load(&reset_requests) & (1U << stage)) {
+        atomic_fetch_and(&reset_requests, ~(1U << stage));
+        memset(histogram, 0, sizeof(*histogram));
+    }
+
+    uint32_t value  = duration > UINT32_MAX ? UINT32_MAX : (uint32_t)duration;
+    uint16_t bucket = 0;
+    while (bucket < PROFILER_NUM_BUCKETS - 1 && value > bucket_limits[bucket]) {
+        bucket++;
+    }
+
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    histogram->total += value;
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+}
+
+
+/*
+ *  The copy is not synchronized with the recording task, so it may be off by the sample being recorded
+ */
+void profiler_get(profiler_stage_t stage, profiler_histogram_t *histogram) {
+    memcpy(histogram, &histograms[stage], sizeof(*histogram));
+}
+
+
+/*
+ *  Upper limit of `bucket` in microseconds, UINT32_MAX for the last one
+ */
+uint32_t profiler_bucket_limit(uint16_t bucket) {
+    return bucket < PROFILER_NUM_BUCKETS - 1 ? bucket_limits[bucket] : UINT32_MAX;
+}
+
+
+void profiler_reset(void) {
+    atomic_fetch_or(&reset_requests, (1U << PROFILER_NUM_STAGES) - 1);
+}
+
+
+#endif
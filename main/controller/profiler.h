@@ -0,0 +1,62 @@
+#ifndef PROFILER_H_INCLUDED
+#define PROFILER_H_INCLUDED
+
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "utils/utils.h"
+
+
+#define PROFILER_NUM_BUCKETS 12
+
+
+typedef enum {
+    PROFILER_STAGE_UART_READ = 0,
+    PROFILER_STAGE_RTU_PARSE,
+    PROFILER_STAGE_RESPONSE_WRITE,
+    PROFILER_STAGE_SENSOR_READ,
+    PROFILER_STAGE_SAFETY_EVALUATION,
+    PROFILER_STAGE_LED_UPDATE,
+    PROFILER_STAGE_REQUEST_TO_RESPONSE,
+} profiler_stage_t;
+
+#define PROFILER_NUM_STAGES 7
+
+
+/*
+ *  Durations of one stage in microseconds; the last bucket collects everything above the last limit
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t max;
+    uint64_t total;
+    uint32_t buckets[PROFILER_NUM_BUCKETS];
+} profiler_histogram_t;
+
+
+#ifdef CONFIG_EASYCONNECT_PROFILER
+
+/*
+ *  `PROFILER_BEGIN` and `PROFILER_END` must enclose the stage in the same block; without
+ *  CONFIG_EASYCONNECT_PROFILER they expand to nothing
+ */
+#define PROFILER_BEGIN(stage) uint64_t profiler_start_##stage = get_micros()
+#define PROFILER_END(stage)   profiler_record(stage, get_micros() - profiler_start_##stage)
+// For stages that start in another task, `since` being a get_micros() timestamp
+#define PROFILER_RECORD_SINCE(stage, since) profiler_record(stage, get_micros() - (since))
+
+void     profiler_record(profiler_stage_t stage, uint64_t duration);
+void     profiler_get(profiler_stage_t stage, profiler_histogram_t *histogram);
+uint32_t profiler_bucket_limit(uint16_t bucket);
+void     profiler_reset(void);
+
+#else
+
+#define PROFILER_BEGIN(stage)
+#define PROFILER_END(stage)
+#define PROFILER_RECORD_SINCE(stage, since)
+
+#endif
+
+
+#endif
@@ -1,6 +1,69 @@
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
 #include "peripherals/digin.h"
+#include "config/app_config.h"
+#include "utils/utils.h"
+#include "utils/seqlock.h"
 #include "sensors.h"
+#include "latency.h"
+#include "profiler.h"
+#include "minion.h"
+#include "approval.h"
 #include "model/model.h"
+#include "safety.h"
+
+
+#define EVENT_EVALUATE 0x01
+
+
+static void safety_task(void *args);
+static void record_latency(latency_source_t source, uint64_t since, uint64_t edge, uint64_t detection,
+                           uint64_t evaluation, uint64_t output);
+
+
+static EventGroupHandle_t events;
+// Outcome of the last evaluation, for whoever needs to display it
+static atomic_uint status = 0;
+// Latencies from a safety condition failing to the approval output, private to the task and published as summaries
+static latency_t         latencies[LATENCY_NUM_SOURCES];
+static seqlock_t         latency_locks[LATENCY_NUM_SOURCES];
+static latency_summary_t latency_summaries[LATENCY_NUM_SOURCES][2] = {0};
+
+
+/*
+ *  Starts the task that owns the approval output. It samples and debounces the safety input every
+ *  APP_CONFIG_SAFETY_PERIOD_MS and evaluates the safety conditions right after, and also right away when the pressure
+ *  crosses a threshold or the heartbeat times out. Must be called before `sensors_init`.
+ */
+void safety_init(model_t *pmodel) {
+    static StaticEventGroup_t event_group_buffer;
+    events = xEventGroupCreateStatic(&event_group_buffer);
+
+    for (latency_source_t source = 0; source < LATENCY_NUM_SOURCES; source++) {
+        latency_init(&latencies[source]);
+        seqlock_init(&latency_locks[source]);
+    }
+
+    sensors_set_threshold_notification(events, EVENT_EVALUATE);
+    minion_set_heartbeat_notification(events, EVENT_EVALUATE);
+
+    static StaticTask_t static_task;
+    static StackType_t  task_stack[APP_CONFIG_BASE_TASK_STACK_SIZE * 4];
+    xTaskCreateStatic(safety_task, "Safety", sizeof(task_stack) / sizeof(StackType_t), pmodel,
+                      APP_CONFIG_SAFETY_TASK_PRIORITY, task_stack, &static_task);
+}
+
+
+uint8_t safety_get_status(void) {
+    return (uint8_t)atomic_load(&status);
+}
+
+
+void safety_get_latency(latency_source_t source, latency_summary_t *summary) {
+    seqlock_read(&latency_locks[source], latency_summaries[source], summary, sizeof(*summary));
+}
 
 
 uint8_t safety_signal_ok(model_t *pmodel) {
@@ -8,6 +71,107 @@ uint8_t safety_signal_ok(model_t *pmodel) {
 }
 
 
-uint8_t safety_pressure_ok(model_t *pmodel) {
-    return model_is_pressure_ok(pmodel);
+uint8_t safety_pressure_slope_ok(const model_snapshot_t *snapshot) {
+    uint16_t alarm = snapshot->pressure_slope_alarm;
+    int32_t  slope = sensors_get_pressure_slope();
+    return alarm == 0 || (slope < 0 ? -slope : slope) <= alarm;
+}
+
+
+static void safety_task(void *args) {
+    model_t     *pmodel              = args;
+    unsigned int previous_status     = 0;
+    uint64_t     previous_evaluation = 0;
+    TickType_t   next_sample         = xTaskGetTickCount();
+    uint8_t      heartbeat_missing   = 0;
+
+    for (;;) {
+        // Events only bring the evaluation forward, the input keeps being sampled on its fixed schedule
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(next_sample - now) > 0) {
+            xEventGroupWaitBits(events, EVENT_EVALUATE, pdTRUE, pdFALSE, next_sample - now);
+        }
+        if ((int32_t)(xTaskGetTickCount() - next_sample) >= 0) {
+            digin_sample();
+            next_sample += pdMS_TO_TICKS(APP_CONFIG_SAFETY_PERIOD_MS);
+            if ((int32_t)(xTaskGetTickCount() - next_sample) >= 0) {
+                // Fell behind: skip the missed samples instead of taking them back to back, which would shorten
+                // the debounce
+                next_sample = xTaskGetTickCount() + pdMS_TO_TICKS(APP_CONFIG_SAFETY_PERIOD_MS);
+            }
+        }
+
+        int16_t temperature = 0;
+        int16_t pressure    = 0;
+        int16_t humidity    = 0;
+
+        PROFILER_BEGIN(PROFILER_STAGE_SENSOR_READ);
+        sensors_read(&temperature, &pressure, &humidity);
+        model_set_readings(pmodel, temperature, pressure, humidity);
+        PROFILER_END(PROFILER_STAGE_SENSOR_READ);
+
+        // The heartbeat timer only raises a flag, the model is updated from here where blocking is fine
+        uint8_t missing_heartbeat = minion_is_heartbeat_missing();
+        if (missing_heartbeat != heartbeat_missing) {
+            model_set_missing_heartbeat(pmodel, missing_heartbeat);
+            heartbeat_missing = missing_heartbeat;
+        }
+
+        PROFILER_BEGIN(PROFILER_STAGE_SAFETY_EVALUATION);
+        model_snapshot_t snapshot = {0};
+        model_get_snapshot(pmodel, &snapshot);
+
+        uint64_t evaluation   = get_micros();
+        uint8_t  signal_ok    = safety_signal_ok(pmodel);
+        uint8_t  pressure_ok  = model_snapshot_is_pressure_ok(&snapshot);
+        uint8_t  heartbeat_ok = !missing_heartbeat;
+
+        if (signal_ok && pressure_ok && heartbeat_ok) {
+            approval_on();
+        } else {
+            approval_off();
+        }
+        uint64_t output = get_micros();
+        PROFILER_END(PROFILER_STAGE_SAFETY_EVALUATION);
+
+        unsigned int new_status = 0;
+        new_status |= signal_ok ? SAFETY_STATUS_SIGNAL_OK : 0;
+        new_status |= pressure_ok ? SAFETY_STATUS_PRESSURE_OK : 0;
+        new_status |= heartbeat_ok ? SAFETY_STATUS_HEARTBEAT_OK : 0;
+        atomic_store(&status, new_status);
+
+        // Only conditions going from ok to failed count, as that is when approval is dropped
+        uint64_t edge      = 0;
+        uint64_t detection = 0;
+        if ((previous_status & SAFETY_STATUS_SIGNAL_OK) && !signal_ok) {
+            digin_get_timestamps(&edge, &detection);
+            record_latency(LATENCY_SOURCE_SIGNAL, previous_evaluation, edge, detection, evaluation, output);
+        }
+        if ((previous_status & SAFETY_STATUS_PRESSURE_OK) && !pressure_ok) {
+            sensors_get_threshold_crossing(&edge, &detection);
+            record_latency(LATENCY_SOURCE_PRESSURE, previous_evaluation, edge, detection, evaluation, output);
+        }
+
+        previous_status     = new_status;
+        previous_evaluation = evaluation;
+    }
+
+    vTaskDelete(NULL);
+}
+
+
+/*
+ *  `since` is the previous evaluation, which still found the condition ok: a detection older than that belongs to
+ *  some other change (e.g. the model and sampler thresholds being updated) and would be meaningless
+ */
+static void record_latency(latency_source_t source, uint64_t since, uint64_t edge, uint64_t detection,
+                           uint64_t evaluation, uint64_t output) {
+    if (edge == 0 || detection < since) {
+        return;
+    }
+
+    latency_summary_t summary = {0};
+    latency_add(&latencies[source], edge, detection, evaluation, output);
+    latency_summarize(&latencies[source], &summary);
+    seqlock_publish(&latency_locks[source], latency_summaries[source], &summary, sizeof(summary));
 }
\ No newline at end of file
@@ -4,10 +4,19 @@
 
 #include <stdint.h>
 #include "model/model.h"
+#include "latency.h"
 
 
+#define SAFETY_STATUS_SIGNAL_OK    0x01
+#define SAFETY_STATUS_PRESSURE_OK  0x02
+#define SAFETY_STATUS_HEARTBEAT_OK 0x04
+
+
+void    safety_init(model_t *pmodel);
+uint8_t safety_get_status(void);
+void    safety_get_latency(latency_source_t source, latency_summary_t *summary);
 uint8_t safety_signal_ok(model_t *pmodel);
-uint8_t safety_pressure_ok(model_t *pmodel);
+uint8_t safety_pressure_slope_ok(const model_snapshot_t *snapshot);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "schedule.h"
+
+
+void schedule_init(schedule_t *schedule, TickType_t period) {
+    schedule->overruns = 0;
+    schedule_restart(schedule, period);
+}
+
+
+/*
+ *  Takes the current tick as the new reference, e.g. after an error or a change of period
+ */
+void schedule_restart(schedule_t *schedule, TickType_t period) {
+    schedule->period    = period > 0 ? period : 1;
+    schedule->last_wake = xTaskGetTickCount();
+}
+
+
+/*
+ *  Blocks until the next activation. Returns 1 if the deadline had already passed, 0 otherwise
+ */
+int schedule_wait(schedule_t *schedule) {
+    TickType_t now = xTaskGetTickCount();
+
+    if ((TickType_t)(now - schedule->last_wake) > schedule->period) {
+        schedule->overruns++;
+        schedule->last_wake = now;
+        return 1;
+    }
+
+    vTaskDelayUntil(&schedule->last_wake, schedule->period);
+    return 0;
+}
@@ -0,0 +1,27 @@
+#ifndef SCHEDULE_H_INCLUDED
+#define SCHEDULE_H_INCLUDED
+
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+
+/*
+ *  Fixed-rate periodic schedule: activations happen at multiples of the period from the reference tick,
+ *  regardless of how long the work in between takes.
+ *  When the work overruns the deadline the missed activations are skipped and counted, and the schedule
+ *  restarts from the current tick instead of trying to catch up with a burst.
+ */
+typedef struct {
+    TickType_t last_wake;
+    TickType_t period;
+    uint32_t   overruns;
+} schedule_t;
+
+
+void schedule_init(schedule_t *schedule, TickType_t period);
+void schedule_restart(schedule_t *schedule, TickType_t period);
+int  schedule_wait(schedule_t *schedule);
+
+
+#endif
@@ -1,41 +1,171 @@
+#include <stdatomic.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/timers.h"
-#include "freertos/semphr.h"
 #include "esp_log.h"
+#include "esp_rom_sys.h"
 #include "peripherals/i2c_devices.h"
-#include "i2c_devices/temperature/MS5837/ms5837.h"
 #include "i2c_devices/temperature/SHTC3/shtc3.h"
 #include "config/app_config.h"
+#include "gel/timer/timecheck.h"
+#include "utils/utils.h"
+#include "utils/seqlock.h"
+#include "compensation.h"
+#include "filter.h"
+#include "capture.h"
+#include "timing.h"
+#include "schedule.h"
+#include "statistics.h"
+#include "sensors.h"
+
+
+#define NUM_SAMPLES_PRESSURE APP_CONFIG_MAXIMUM_PRESSURE_WINDOW
+#define NUM_SAMPLES_SHTC3    5
+#define NUM_PRESSURE_OSR     6     // Oversampling indexes from 0 (OSR 256) to 5 (OSR 8192)
 
+#if APP_CONFIG_SHTC3_LOW_POWER
+#define SHTC3_MEASUREMENT_PERIOD_MS I2C_DEVICES_SHTC3_LOW_POWER_MEASUREMENT_PERIOD_MS
+#else
+#define SHTC3_MEASUREMENT_PERIOD_MS SHTC3_NORMAL_MEASUREMENT_PERIOD_MS
+#endif
+
+#define SHTC3_WAKEUP_US 240
+
+// A delay of n ticks may end right after the next tick boundary, so one more tick guarantees at least `ms`
+#define DELAY_TICKS_AT_LEAST(ms) ((TickType_t)(((ms)*configTICK_RATE_HZ + 999) / 1000 + 1))
+
+#define STANDARD_ATMOSPHERE_PA 101325L
+
+#define PRESSURE_SLOPE_PERIOD_US (APP_CONFIG_PRESSURE_SLOPE_PERIOD_MS * 1000ULL)
+#define PRESSURE_SLOPE_SCALE     (10 * 1000 / APP_CONFIG_PRESSURE_SLOPE_PERIOD_MS)     // 0.1 Pa/s per Pa/step
+
+#define PRESSURE_SAMPLING(osr, window, period)                                                                         \
+    (((uint32_t)(period) << 24) | ((uint32_t)(osr) << 16) | (window))
+#define PRESSURE_SAMPLING_PERIOD(sampling) ((uint8_t)((sampling) >> 24))
+#define PRESSURE_SAMPLING_OSR(sampling)    ((uint8_t)(((sampling) >> 16) & 0xFF))
+#define PRESSURE_SAMPLING_WINDOW(sampling) ((uint16_t)((sampling)&0xFFFF))
+
+#define PRESSURE_THRESHOLDS(minimum, maximum)  (((uint32_t)(minimum) << 16) | (maximum))
+#define PRESSURE_THRESHOLD_MINIMUM(thresholds) ((uint16_t)((thresholds) >> 16))
+#define PRESSURE_THRESHOLD_MAXIMUM(thresholds) ((uint16_t)((thresholds)&0xFFFF))
+
+#define STATISTICS_CONFIGURATION(window, reset_on_read) (((uint32_t)(reset_on_read) << 16) | (window))
+#define STATISTICS_WINDOW_US(configuration)             (((configuration)&0xFFFF) * 1000000ULL)
+#define STATISTICS_RESET_ON_READ(configuration)         ((configuration) >> 16)
+
+#define FILTER_TYPE(types, channel) ((filter_type_t)(((types) >> ((channel)*8)) & 0xFF))
+
+
+typedef enum {
+    MS5837_STATE_SETUP = 0,
+    MS5837_STATE_START,
+    MS5837_STATE_COLLECT_TEMPERATURE,
+    MS5837_STATE_COLLECT_PRESSURE,
+} ms5837_state_t;
+
+typedef enum {
+    SHTC3_STATE_WAKEUP = 0,
+    SHTC3_STATE_START,
+    SHTC3_STATE_READ,
+    SHTC3_STATE_SLEEP,
+    SHTC3_STATE_IDLE,
+} shtc3_state_t;
+
+
+typedef struct {
+    uint64_t timestamp;       // Microseconds at the end of the last conversion
+    int32_t  pressure;        // Absolute pressure in Pa
+    uint16_t sample_rate;     // Pressure samples collected in the last second
+    uint16_t rejected;        // Samples discarded by the spike gates, saturated
+    int32_t  slope;           // Pressure derivative in 0.1 Pa/s
+    uint8_t  error;
+} pressure_reading_t;
+
+
+typedef struct {
+    uint64_t timestamp;     // Microseconds at the end of the last measurement
+    int16_t  temperature;
+    int16_t  humidity;
+    uint8_t  error;
+} temperature_humidity_reading_t;
 
-#define NUM_SAMPLES_PRESSURE 200
-#define NUM_SAMPLES_SHTC3    5
 
+typedef struct {
+    statistics_t accumulator;
+    uint64_t     window_start;
+} channel_statistics_t;
 
-static void temperature_task(void *args);
-static void pressure_task(void *args);
+
+typedef struct {
+    uint64_t sample;        // Microseconds at the start of the conversion that crossed
+    uint64_t detection;     // Microseconds when the crossing was noticed, after filtering
+} threshold_crossing_t;
+
+
+static void       temperature_task(void *args);
+static void       pressure_task(void *args);
+static int        ms5837_setup(compensation_ms5837_t *compensation);
+static int        shtc3_start_measurement(void);
+static TickType_t pressure_period_ticks(uint32_t sampling);
+static int16_t    relative_pressure(int32_t pressure);
+static uint8_t    pressure_within_thresholds(int32_t pressure, uint32_t thresholds);
+static void       channel_statistics_add(sensors_channel_t channel, int32_t sample, uint64_t timestamp);
 
 
 static const char *TAG = "Sensors";
 
 
-static SemaphoreHandle_t sem                                          = NULL;
-static double            temperatures[NUM_SAMPLES_SHTC3]              = {0};
-static double            humidities[NUM_SAMPLES_SHTC3]                = {0};
-static uint32_t          temperature_adc_buffer[NUM_SAMPLES_PRESSURE] = {0};
-static uint32_t          pressure_adc_buffer[NUM_SAMPLES_PRESSURE]    = {0};
-static size_t            ms5837_sample_index                          = 0;
-static uint8_t           ms5837_full_circle                           = 0;
-static ms5837_prom_t     ms5837_data;
-static size_t            shtc3_sample_index         = 0;
-static uint8_t           shtc3_full_circle          = 0;
-static uint8_t           temperature_humidity_error = 0;
-static uint8_t           pressure_error             = 0;
+// Filter histories are private to the sampling tasks
+static int32_t temperature_filter_buffer[NUM_SAMPLES_SHTC3]            = {0};
+static int32_t humidity_filter_buffer[NUM_SAMPLES_SHTC3]               = {0};
+static int32_t pressure_filter_buffer[NUM_SAMPLES_PRESSURE]            = {0};
+static int32_t pressure_slope_buffer[APP_CONFIG_PRESSURE_SLOPE_WINDOW] = {0};
+// So are the timing and statistics accumulators, too large for the task stacks
+static timing_t ms5837_timing;
+static timing_t shtc3_timing;
+static channel_statistics_t channel_statistics[SENSORS_NUM_CHANNELS] = {0};
+
+// The filtered readings are published to the consumers through a sequence lock, without any mutex
+static seqlock_t                      pressure_lock;
+static pressure_reading_t             pressure_readings[2]             = {0};
+static seqlock_t                      temperature_humidity_lock;
+static temperature_humidity_reading_t temperature_humidity_readings[2] = {0};
+// Sampling statistics of each device, refreshed once per window
+static seqlock_t        timing_locks[SENSORS_NUM_DEVICES];
+static timing_summary_t timing_summaries[SENSORS_NUM_DEVICES][2] = {0};
+
+// Period, oversampling index and averaging window requested for the pressure sampler, packed in a single word
+static atomic_uint pressure_sampling = PRESSURE_SAMPLING(NUM_PRESSURE_OSR - 1, NUM_SAMPLES_PRESSURE, 0);
+// Filter type of each channel, one byte per channel
+static atomic_uint filter_types = 0;
+// Pressure thresholds, packed in a single word, and the event bits to set when the pressure crosses them
+static atomic_uint        pressure_thresholds = PRESSURE_THRESHOLDS(APP_CONFIG_DEFAULT_MINIMUM_PRESSURE_THRESHOLD,
+                                                                    APP_CONFIG_DEFAULT_MAXIMUM_PRESSURE_THRESHOLD);
+static EventGroupHandle_t threshold_events    = NULL;
+static EventBits_t        threshold_bits      = 0;
+// Timing of the last threshold crossing, for the latency measurements
+static seqlock_t            threshold_crossing_lock;
+static threshold_crossing_t threshold_crossings[2] = {0};
+// Statistics window and reset-on-read mode, plus one reset request bit per channel
+static atomic_uint statistics_configuration =
+    STATISTICS_CONFIGURATION(APP_CONFIG_DEFAULT_STATISTICS_WINDOW_S, APP_CONFIG_DEFAULT_STATISTICS_RESET_ON_READ);
+static atomic_uint statistics_reset_requests = 0;
+// Statistics are published as raw accumulators, the readers summarize them
+static seqlock_t    statistics_locks[SENSORS_NUM_CHANNELS];
+static statistics_t statistics_published[SENSORS_NUM_CHANNELS][2] = {0};
+// Activations of each sampler that started after their deadline
+static atomic_uint overruns[SENSORS_NUM_DEVICES] = {0};
 
 
 void sensors_init(uint8_t pressure, uint8_t temperature_humidity) {
-    static StaticSemaphore_t semaphore_buffer;
-    sem = xSemaphoreCreateMutexStatic(&semaphore_buffer);
+    seqlock_init(&pressure_lock);
+    seqlock_init(&threshold_crossing_lock);
+    seqlock_init(&temperature_humidity_lock);
+    for (size_t i = 0; i < SENSORS_NUM_DEVICES; i++) {
+        seqlock_init(&timing_locks[i]);
+    }
+    for (size_t i = 0; i < SENSORS_NUM_CHANNELS; i++) {
+        seqlock_init(&statistics_locks[i]);
+    }
 
     if (pressure) {
         static StaticTask_t static_task;
@@ -54,89 +184,279 @@ void sensors_init(uint8_t pressure, uint8_t temperature_humidity) {
 }
 
 
-void sensors_read(double *temperature, double *pressure, double *humidity) {
-    xSemaphoreTake(sem, portMAX_DELAY);
-    size_t ms5837_total = ms5837_full_circle ? NUM_SAMPLES_PRESSURE : ms5837_sample_index;
+/*
+ *  Pressure is reported in Pa relative to the standard atmosphere (1013.25 mBar), saturated to the int16 range.
+ */
+void sensors_read(int16_t *temperature, int16_t *pressure, int16_t *humidity) {
+    pressure_reading_t             pressure_reading             = {0};
+    temperature_humidity_reading_t temperature_humidity_reading = {0};
+
+    seqlock_read(&pressure_lock, pressure_readings, &pressure_reading, sizeof(pressure_reading));
+    seqlock_read(&temperature_humidity_lock, temperature_humidity_readings, &temperature_humidity_reading,
+                 sizeof(temperature_humidity_reading));
+
+    *pressure    = relative_pressure(pressure_reading.pressure);
+    *temperature = temperature_humidity_reading.temperature;
+    *humidity    = temperature_humidity_reading.humidity;
+}
+
+
+uint8_t sensors_get_errors(void) {
+    pressure_reading_t             pressure_reading             = {0};
+    temperature_humidity_reading_t temperature_humidity_reading = {0};
+
+    seqlock_read(&pressure_lock, pressure_readings, &pressure_reading, sizeof(pressure_reading));
+    seqlock_read(&temperature_humidity_lock, temperature_humidity_readings, &temperature_humidity_reading,
+                 sizeof(temperature_humidity_reading));
+
+    return (temperature_humidity_reading.error > 0) | ((pressure_reading.error > 0) << 1);
+}
+
+
+/*
+ *  A `period` of 0 ms, or shorter than the conversion time, samples as fast as the oversampling ratio allows
+ */
+void sensors_set_pressure_sampling(uint16_t osr, uint16_t window, uint16_t period) {
+    uint8_t osr_index = 0;
+    while (osr_index < NUM_PRESSURE_OSR - 1 && (256U << osr_index) < osr) {
+        osr_index++;
+    }
 
-    uint64_t temperature_sum = 0;
-    uint64_t pressure_sum    = 0;
+    if (window == 0 || window > NUM_SAMPLES_PRESSURE) {
+        window = NUM_SAMPLES_PRESSURE;
+    }
 
-    for (size_t i = 0; i < ms5837_total; i++) {
-        temperature_sum += temperature_adc_buffer[i];
-        pressure_sum += pressure_adc_buffer[i];
+    if (period > APP_CONFIG_MAXIMUM_PRESSURE_PERIOD_MS) {
+        period = APP_CONFIG_MAXIMUM_PRESSURE_PERIOD_MS;
     }
 
-    size_t shtc3_total = shtc3_full_circle ? NUM_SAMPLES_SHTC3 : shtc3_sample_index;
+    atomic_store(&pressure_sampling, PRESSURE_SAMPLING(osr_index, window, period));
+}
+
+
+/*
+ *  Thresholds use the same units as the model (tens of Pa, offset by 1000)
+ */
+void sensors_set_pressure_thresholds(uint16_t minimum, uint16_t maximum) {
+    atomic_store(&pressure_thresholds, PRESSURE_THRESHOLDS(minimum, maximum));
+}
 
-    double shtc3_temperature_sum = 0;
-    double humidity_sum          = 0;
 
-    for (size_t i = 0; i < shtc3_total; i++) {
-        shtc3_temperature_sum += temperatures[i];
-        humidity_sum += humidities[i];
+/*
+ *  `bits` are set in `event_group` as soon as a filtered pressure sample crosses one of the thresholds.
+ *  Must be called before `sensors_init`.
+ */
+void sensors_set_threshold_notification(EventGroupHandle_t event_group, EventBits_t bits) {
+    threshold_bits   = bits;
+    threshold_events = event_group;
+}
+
+
+/*
+ *  With `reset_on_read` the statistics accumulate until `sensors_reset_statistics` is called, otherwise they are
+ *  those of the last complete window of `window` seconds
+ */
+void sensors_set_statistics(uint16_t window, uint8_t reset_on_read) {
+    if (window == 0) {
+        window = 1;
     }
+    atomic_store(&statistics_configuration, STATISTICS_CONFIGURATION(window, reset_on_read > 0));
+}
 
-    xSemaphoreGive(sem);
 
-    if (ms5837_total == 0) {
-        *pressure = 0;
-    } else {
-        ms5837_calculate(ms5837_data, temperature_sum / ms5837_total, pressure_sum / ms5837_total, NULL, pressure);
+void sensors_get_statistics(sensors_channel_t channel, statistics_summary_t *summary) {
+    statistics_t statistics = {0};
+    seqlock_read(&statistics_locks[channel], statistics_published[channel], &statistics, sizeof(statistics));
+    statistics_summarize(&statistics, summary);
+}
+
+
+/*
+ *  Restarts the accumulation of all channels; the samplers apply it on their next sample
+ */
+void sensors_reset_statistics(void) {
+    atomic_fetch_or(&statistics_reset_requests, (1U << SENSORS_NUM_CHANNELS) - 1);
+}
+
+
+uint32_t sensors_get_overruns(sensors_device_t device) {
+    return atomic_load(&overruns[device]);
+}
+
+
+/*
+ *  Timestamps (us) of the start of the conversion that last crossed a pressure threshold and of its detection
+ */
+void sensors_get_threshold_crossing(uint64_t *sample, uint64_t *detection) {
+    threshold_crossing_t crossing = {0};
+    seqlock_read(&threshold_crossing_lock, threshold_crossings, &crossing, sizeof(crossing));
+    *sample    = crossing.sample;
+    *detection = crossing.detection;
+}
+
+
+void sensors_set_filter(sensors_channel_t channel, uint8_t type) {
+    if (channel >= SENSORS_NUM_CHANNELS || type >= FILTER_TYPE_NUM) {
+        return;
     }
 
-    if (shtc3_total == 0) {
-        *temperature = 0;
-        *humidity    = 0;
-    } else {
-        *temperature = shtc3_temperature_sum / ((double)shtc3_total);
-        *humidity    = humidity_sum / ((double)shtc3_total);
+    unsigned int types = atomic_load(&filter_types);
+    unsigned int updated;
+    do {
+        updated = (types & ~(0xFFU << (channel * 8))) | ((unsigned int)type << (channel * 8));
+    } while (!atomic_compare_exchange_weak(&filter_types, &types, updated));
+}
+
+
+/*
+ *  Derivative of the filtered pressure in 0.1 Pa/s, saturated
+ */
+int16_t sensors_get_pressure_slope(void) {
+    pressure_reading_t pressure_reading = {0};
+    seqlock_read(&pressure_lock, pressure_readings, &pressure_reading, sizeof(pressure_reading));
+
+    if (pressure_reading.slope > INT16_MAX) {
+        return INT16_MAX;
+    } else if (pressure_reading.slope < INT16_MIN) {
+        return INT16_MIN;
     }
+    return (int16_t)pressure_reading.slope;
 }
 
 
-uint8_t sensors_get_errors(void) {
-    xSemaphoreTake(sem, portMAX_DELAY);
-    uint8_t res = (temperature_humidity_error > 0) | ((pressure_error > 0) << 1);
-    xSemaphoreGive(sem);
-    return res;
+uint16_t sensors_get_pressure_rejected_samples(void) {
+    pressure_reading_t pressure_reading = {0};
+    seqlock_read(&pressure_lock, pressure_readings, &pressure_reading, sizeof(pressure_reading));
+    return pressure_reading.rejected;
+}
+
+
+uint16_t sensors_get_pressure_sample_rate(void) {
+    pressure_reading_t pressure_reading = {0};
+    seqlock_read(&pressure_lock, pressure_readings, &pressure_reading, sizeof(pressure_reading));
+    return pressure_reading.sample_rate;
+}
+
+
+void sensors_get_timing(sensors_device_t device, timing_summary_t *summary) {
+    seqlock_read(&timing_locks[device], timing_summaries[device], summary, sizeof(*summary));
+}
+
+
+uint64_t sensors_get_sample_timestamp(sensors_device_t device) {
+    if (device == SENSORS_DEVICE_MS5837) {
+        pressure_reading_t pressure_reading = {0};
+        seqlock_read(&pressure_lock, pressure_readings, &pressure_reading, sizeof(pressure_reading));
+        return pressure_reading.timestamp;
+    } else {
+        temperature_humidity_reading_t temperature_humidity_reading = {0};
+        seqlock_read(&temperature_humidity_lock, temperature_humidity_readings, &temperature_humidity_reading,
+                     sizeof(temperature_humidity_reading));
+        return temperature_humidity_reading.timestamp;
+    }
 }
 
 
 static void temperature_task(void *args) {
     (void)args;
-    shtc3_wakeup(shtc3_driver);
+
+    filter_t                       temperature_filter;
+    filter_t                       humidity_filter;
+    unsigned int                   types            = atomic_load(&filter_types);
+    temperature_humidity_reading_t reading          = {0};
+    shtc3_state_t                  state            = SHTC3_STATE_WAKEUP;
+    uint64_t                       conversion_start = 0;
+    timing_t                      *timing           = &shtc3_timing;
+    timing_summary_t               summary;
+
+    filter_init(&temperature_filter, temperature_filter_buffer, NUM_SAMPLES_SHTC3);
+    filter_init(&humidity_filter, humidity_filter_buffer, NUM_SAMPLES_SHTC3);
+    filter_configure(&temperature_filter, FILTER_TYPE(types, SENSORS_CHANNEL_TEMPERATURE), NUM_SAMPLES_SHTC3);
+    filter_configure(&humidity_filter, FILTER_TYPE(types, SENSORS_CHANNEL_HUMIDITY), NUM_SAMPLES_SHTC3);
+
+    // Measurements are scheduled on a fixed period; the sensor sleeps in between
+    schedule_t schedule;
+    schedule_init(&schedule, pdMS_TO_TICKS(APP_CONFIG_SHTC3_PERIOD_MS));
+    timing_init(timing, get_micros());
 
     for (;;) {
-        int16_t temperature = 0;
-        int16_t humidity    = 0;
-
-        if (shtc3_start_temperature_humidity_measurement(shtc3_driver) == 0) {
-            vTaskDelay(pdMS_TO_TICKS(SHTC3_NORMAL_MEASUREMENT_PERIOD_MS));
-
-            if (shtc3_read_temperature_humidity_measurement(shtc3_driver, &temperature, &humidity) == 0) {
-                xSemaphoreTake(sem, portMAX_DELAY);
-                temperatures[shtc3_sample_index] = (double)temperature;
-                humidities[shtc3_sample_index]   = (double)humidity;
-                if (shtc3_sample_index == NUM_SAMPLES_SHTC3 - 1) {
-                    shtc3_full_circle = 1;
+        switch (state) {
+            case SHTC3_STATE_WAKEUP:
+                if (atomic_load(&filter_types) != types) {
+                    types = atomic_load(&filter_types);
+                    filter_configure(&temperature_filter, FILTER_TYPE(types, SENSORS_CHANNEL_TEMPERATURE),
+                                     NUM_SAMPLES_SHTC3);
+                    filter_configure(&humidity_filter, FILTER_TYPE(types, SENSORS_CHANNEL_HUMIDITY),
+                                     NUM_SAMPLES_SHTC3);
+                }
+
+                if (shtc3_wakeup(shtc3_driver) == 0) {
+                    state = SHTC3_STATE_START;
+                    // Wakeup takes up to 240 us, too short to be worth a context switch
+                    esp_rom_delay_us(SHTC3_WAKEUP_US);
+                } else {
+                    reading.error = 1;
+                    ESP_LOGD(TAG, "Error in waking up temperature sensor");
+                    state = SHTC3_STATE_IDLE;
+                }
+                break;
+
+            case SHTC3_STATE_START:
+                if (shtc3_start_measurement() == 0) {
+                    conversion_start = get_micros();
+                    state            = SHTC3_STATE_READ;
+                    // The low power command does not stretch the clock, reading early would fail or return stale data
+                    vTaskDelay(DELAY_TICKS_AT_LEAST(SHTC3_MEASUREMENT_PERIOD_MS));
+                } else {
+                    reading.error = 1;
+                    ESP_LOGD(TAG, "Error in starting temperature measurement");
+                    state = SHTC3_STATE_SLEEP;
                 }
-                shtc3_sample_index         = (shtc3_sample_index + 1) % NUM_SAMPLES_SHTC3;
-                temperature_humidity_error = 0;
-                xSemaphoreGive(sem);
-            } else {
-                xSemaphoreTake(sem, portMAX_DELAY);
-                temperature_humidity_error = 1;
-                xSemaphoreGive(sem);
-                ESP_LOGD(TAG, "Error in reading temperature measurement");
+                break;
+
+            case SHTC3_STATE_READ: {
+                int16_t temperature = 0;
+                int16_t humidity    = 0;
+
+                if (shtc3_read_temperature_humidity_measurement(shtc3_driver, &temperature, &humidity) == 0) {
+                    reading.timestamp = get_micros();
+                    timing_add_sample(timing, reading.timestamp, (uint32_t)(reading.timestamp - conversion_start));
+
+                    reading.temperature = (int16_t)filter_push(&temperature_filter, temperature);
+                    reading.humidity    = (int16_t)filter_push(&humidity_filter, humidity);
+                    reading.error       = 0;
+
+                    channel_statistics_add(SENSORS_CHANNEL_TEMPERATURE, reading.temperature, reading.timestamp);
+                    channel_statistics_add(SENSORS_CHANNEL_HUMIDITY, reading.humidity, reading.timestamp);
+                } else {
+                    reading.error = 1;
+                    ESP_LOGD(TAG, "Error in reading temperature measurement");
+                }
+                state = SHTC3_STATE_SLEEP;
+                break;
             }
-        } else {
-            xSemaphoreTake(sem, portMAX_DELAY);
-            temperature_humidity_error = 1;
-            xSemaphoreGive(sem);
-            ESP_LOGD(TAG, "Error in starting temperature measurement");
-        }
 
-        vTaskDelay(pdMS_TO_TICKS(200));
+            case SHTC3_STATE_SLEEP:
+                if (i2c_devices_shtc3_sleep() != 0) {
+                    ESP_LOGD(TAG, "Error in putting temperature sensor to sleep");
+                }
+                state = SHTC3_STATE_IDLE;
+                break;
+
+            case SHTC3_STATE_IDLE:
+                seqlock_publish(&temperature_humidity_lock, temperature_humidity_readings, &reading, sizeof(reading));
+
+                if (get_micros() - timing->window_start >= APP_CONFIG_TIMING_WINDOW_MS * 1000ULL) {
+                    timing_summarize(timing, get_micros(), &summary);
+                    seqlock_publish(&timing_locks[SENSORS_DEVICE_SHTC3], timing_summaries[SENSORS_DEVICE_SHTC3],
+                                    &summary, sizeof(summary));
+                }
+                state = SHTC3_STATE_WAKEUP;
+                if (schedule_wait(&schedule)) {
+                    atomic_store(&overruns[SENSORS_DEVICE_SHTC3], schedule.overruns);
+                }
+                break;
+        }
     }
 
     vTaskDelete(NULL);
@@ -146,44 +466,284 @@ static void temperature_task(void *args) {
 static void pressure_task(void *args) {
     (void)args;
 
-    uint16_t retry_counter = 0;
+    uint16_t              retry_counter        = 0;
+    uint32_t              temperature_adc      = 0;
+    uint16_t              pressure_conversions = 0;
+    uint64_t              conversion_start     = 0;
+    uint8_t               pressure_ok          = 1;
+    uint8_t               raw_pressure_ok      = 1;
+    uint16_t              rate_samples         = 0;
+    unsigned long         rate_timestamp       = get_millis();
+    uint64_t              slope_timestamp      = 0;
+    compensation_ms5837_t compensation         = {0};
+    pressure_reading_t    reading              = {0};
+    ms5837_state_t        state                = MS5837_STATE_SETUP;
+
+    uint32_t   sampling         = atomic_load(&pressure_sampling);
+    uint8_t    osr              = PRESSURE_SAMPLING_OSR(sampling);
+    uint16_t   window           = PRESSURE_SAMPLING_WINDOW(sampling);
+    TickType_t conversion_ticks = pdMS_TO_TICKS(i2c_devices_ms5837_conversion_time_ms(osr));
+    schedule_t schedule;
+
+    unsigned int types = atomic_load(&filter_types);
+    filter_t     pressure_filter;
+    filter_init(&pressure_filter, pressure_filter_buffer, NUM_SAMPLES_PRESSURE);
+
+    // A corrupted read that does not report an error must not reach the filter
+    spike_gate_t pressure_gate;
+    spike_gate_t temperature_gate;
+    spike_gate_init(&pressure_gate, APP_CONFIG_PRESSURE_SPIKE_THRESHOLD_PA);
+    spike_gate_init(&temperature_gate, APP_CONFIG_TEMPERATURE_ADC_SPIKE_THRESHOLD);
+    filter_configure(&pressure_filter, FILTER_TYPE(types, SENSORS_CHANNEL_PRESSURE), window);
+
+    slope_t pressure_slope;
+    slope_init(&pressure_slope, pressure_slope_buffer, APP_CONFIG_PRESSURE_SLOPE_WINDOW);
+
+    timing_t        *timing = &ms5837_timing;
+    timing_summary_t summary;
+
+    schedule_init(&schedule, pressure_period_ticks(sampling));
+    timing_init(timing, get_micros());
+
+    /*
+     *  Each step collects the conversion that was started in the previous one and immediately starts the next,
+     *  so the task sleeps one sampling period between steps; by default the period is the conversion time and
+     *  the sensor is never idle.
+     */
+    for (;;) {
+        uint32_t adc = 0;
+        int      res = 0;
 
-    ms5837_init(press_driver, &ms5837_data);
+        if (atomic_load(&pressure_sampling) != sampling) {
+            // Let the conversion in flight complete with its own timing before switching settings
+            vTaskDelay(conversion_ticks);
 
-    for (;;) {
-        uint32_t temperature_adc = 0, pressure_adc = 0;
+            sampling         = atomic_load(&pressure_sampling);
+            osr              = PRESSURE_SAMPLING_OSR(sampling);
+            window           = PRESSURE_SAMPLING_WINDOW(sampling);
+            conversion_ticks = pdMS_TO_TICKS(i2c_devices_ms5837_conversion_time_ms(osr));
 
-        // These functions are blocking
-        int res = ms5837_read_temperature_adc(press_driver, MS5837_OSR_8192, &temperature_adc);
-        res     = res || ms5837_read_pressure_adc(press_driver, MS5837_OSR_8192, &pressure_adc);
+            // Samples taken with the old settings would skew the new window
+            filter_configure(&pressure_filter, FILTER_TYPE(types, SENSORS_CHANNEL_PRESSURE), window);
 
-        if (res) {
-            ESP_LOGW(TAG, "Error reading sensor: %i", res);
+            state = MS5837_STATE_START;
+            schedule_restart(&schedule, pressure_period_ticks(sampling));
+            timing_init(timing, get_micros());
+        }
 
-            xSemaphoreTake(sem, portMAX_DELAY);
-            pressure_error = 1;
-            xSemaphoreGive(sem);
+        if (atomic_load(&filter_types) != types) {
+            types = atomic_load(&filter_types);
+            filter_configure(&pressure_filter, FILTER_TYPE(types, SENSORS_CHANNEL_PRESSURE), window);
+        }
 
-            if ((retry_counter++ % 10) == 0) {
-                ms5837_init(press_driver, &ms5837_data);
-            }
-        } else {
-            retry_counter = 0;
-
-            xSemaphoreTake(sem, portMAX_DELAY);
-            temperature_adc_buffer[ms5837_sample_index] = temperature_adc;
-            pressure_adc_buffer[ms5837_sample_index]    = pressure_adc;
-            ms5837_sample_index++;
-            if (ms5837_sample_index >= NUM_SAMPLES_PRESSURE) {
-                ms5837_full_circle  = 1;
-                ms5837_sample_index = 0;
+        switch (state) {
+            case MS5837_STATE_SETUP:
+                res   = ms5837_setup(&compensation);
+                state = MS5837_STATE_START;
+                // The reset is not part of the periodic work
+                schedule_restart(&schedule, pressure_period_ticks(sampling));
+                break;
+
+            case MS5837_STATE_START:
+                res                  = i2c_devices_ms5837_start_conversion(I2C_DEVICES_MS5837_CONVERT_D2, osr);
+                conversion_start     = get_micros();
+                state                = MS5837_STATE_COLLECT_TEMPERATURE;
+                pressure_conversions = 0;
+                break;
+
+            case MS5837_STATE_COLLECT_TEMPERATURE:
+                res   = i2c_devices_ms5837_read_adc(&adc);
+                res   = res || i2c_devices_ms5837_start_conversion(I2C_DEVICES_MS5837_CONVERT_D1, osr);
+                state = MS5837_STATE_COLLECT_PRESSURE;
+
+                conversion_start = get_micros();
+
+                // An outlier keeps the previous temperature, otherwise it would skew the following pressure samples
+                if (res == 0 && spike_gate_accept(&temperature_gate, (int32_t)adc)) {
+                    temperature_adc = adc;
+                }
+                break;
+
+            case MS5837_STATE_COLLECT_PRESSURE: {
+                res = i2c_devices_ms5837_read_adc(&adc);
+
+                uint64_t timestamp  = get_micros();
+                uint32_t conversion = (uint32_t)(timestamp - conversion_start);
+
+                // Temperature drifts much slower than pressure, so D2 is only refreshed once every few D1 conversions
+                if (++pressure_conversions >= APP_CONFIG_PRESSURE_CONVERSIONS_PER_TEMPERATURE) {
+                    pressure_conversions = 0;
+                    res   = res || i2c_devices_ms5837_start_conversion(I2C_DEVICES_MS5837_CONVERT_D2, osr);
+                    state = MS5837_STATE_COLLECT_TEMPERATURE;
+                } else {
+                    res = res || i2c_devices_ms5837_start_conversion(I2C_DEVICES_MS5837_CONVERT_D1, osr);
+                }
+                conversion_start = get_micros();
+
+                if (res == 0) {
+                    capture_add_sample((uint32_t)timestamp, adc, temperature_adc);
+                    timing_add_sample(timing, timestamp, conversion);
+
+                    // Each sample is compensated with the latest temperature conversion and then filtered; the PROM
+                    // data never leaves this task
+                    int32_t pressure = compensation_ms5837_calculate(&compensation, temperature_adc, adc, NULL);
+                    if (spike_gate_accept(&pressure_gate, pressure)) {
+                        reading.pressure = filter_push(&pressure_filter, pressure);
+
+                        // The capture triggers on the unfiltered sample: the filter delay can be longer than the
+                        // pre-trigger window and the onset of the excursion would already have been overwritten
+                        if (pressure_within_thresholds(pressure, atomic_load(&pressure_thresholds)) !=
+                            raw_pressure_ok) {
+                            raw_pressure_ok = !raw_pressure_ok;
+                            capture_trigger();
+                        }
+                    }
+
+                    // The derivative is taken on the filtered pressure resampled on a fixed grid, so that its window
+                    // spans a known time regardless of the sampling settings
+                    if (timestamp - slope_timestamp >= PRESSURE_SLOPE_PERIOD_US) {
+                        slope_timestamp = timestamp - slope_timestamp >= 2 * PRESSURE_SLOPE_PERIOD_US
+                                              ? timestamp
+                                              : slope_timestamp + PRESSURE_SLOPE_PERIOD_US;
+                        slope_push(&pressure_slope, reading.pressure);
+                        reading.slope = slope_estimate(&pressure_slope, PRESSURE_SLOPE_SCALE);
+                    }
+
+                    uint32_t rejected = pressure_gate.rejected + temperature_gate.rejected;
+                    reading.rejected  = rejected > UINT16_MAX ? UINT16_MAX : (uint16_t)rejected;
+                    reading.timestamp = timestamp;
+                    reading.error     = 0;
+                    retry_counter     = 0;
+
+                    rate_samples++;
+                    if (is_expired(rate_timestamp, get_millis(), 1000UL)) {
+                        reading.sample_rate = rate_samples;
+                        rate_samples        = 0;
+                        rate_timestamp      = get_millis();
+                    }
+
+                    seqlock_publish(&pressure_lock, pressure_readings, &reading, sizeof(reading));
+
+                    channel_statistics_add(SENSORS_CHANNEL_PRESSURE, relative_pressure(reading.pressure), timestamp);
+
+                    // Thresholds are checked on every sample so the safety path does not have to poll for excursions
+                    if (pressure_within_thresholds(reading.pressure, atomic_load(&pressure_thresholds)) !=
+                        pressure_ok) {
+                        pressure_ok = !pressure_ok;
+
+                        threshold_crossing_t crossing = {.sample = timestamp - conversion, .detection = get_micros()};
+                        seqlock_publish(&threshold_crossing_lock, threshold_crossings, &crossing, sizeof(crossing));
+
+                        if (threshold_events != NULL) {
+                            xEventGroupSetBits(threshold_events, threshold_bits);
+                        }
+                    }
+
+                    if (timestamp - timing->window_start >= APP_CONFIG_TIMING_WINDOW_MS * 1000ULL) {
+                        timing_summarize(timing, timestamp, &summary);
+                        seqlock_publish(&timing_locks[SENSORS_DEVICE_MS5837], timing_summaries[SENSORS_DEVICE_MS5837],
+                                        &summary, sizeof(summary));
+                    }
+                }
+                break;
             }
-            pressure_error = 0;
-            xSemaphoreGive(sem);
         }
 
-        vTaskDelay(pdMS_TO_TICKS(2));
+        if (res) {
+            ESP_LOGW(TAG, "Error reading sensor: %i", res);
+
+            reading.error = 1;
+            seqlock_publish(&pressure_lock, pressure_readings, &reading, sizeof(reading));
+
+            // Restart the pipeline from a fresh temperature conversion, resetting the sensor every 10 retries
+            state = (retry_counter++ % 10) == 0 ? MS5837_STATE_SETUP : MS5837_STATE_START;
+            vTaskDelay(pdMS_TO_TICKS(2));
+            schedule_restart(&schedule, pressure_period_ticks(sampling));
+        } else if (schedule_wait(&schedule)) {
+            atomic_store(&overruns[SENSORS_DEVICE_MS5837], schedule.overruns);
+        }
     }
 
     vTaskDelete(NULL);
 }
+
+
+/*
+ *  Resets the sensor and caches the compensation constants from its PROM
+ */
+static int ms5837_setup(compensation_ms5837_t *compensation) {
+    uint16_t prom[COMPENSATION_MS5837_PROM_WORDS] = {0};
+
+    if (i2c_devices_ms5837_reset() || i2c_devices_ms5837_read_prom(prom, COMPENSATION_MS5837_PROM_WORDS)) {
+        return -1;
+    }
+
+    return compensation_ms5837_init(compensation, prom);
+}
+
+
+static int shtc3_start_measurement(void) {
+#if APP_CONFIG_SHTC3_LOW_POWER
+    return i2c_devices_shtc3_start_low_power_measurement();
+#else
+    return shtc3_start_temperature_humidity_measurement(shtc3_driver);
+#endif
+}
+
+
+/*
+ *  The pressure sampling period can be stretched beyond the conversion time, but not shortened
+ */
+static TickType_t pressure_period_ticks(uint32_t sampling) {
+    TickType_t conversion = pdMS_TO_TICKS(i2c_devices_ms5837_conversion_time_ms(PRESSURE_SAMPLING_OSR(sampling)));
+    TickType_t period     = pdMS_TO_TICKS(PRESSURE_SAMPLING_PERIOD(sampling));
+    return period > conversion ? period : conversion;
+}
+
+
+static int16_t relative_pressure(int32_t pressure) {
+    int32_t relative = pressure - STANDARD_ATMOSPHERE_PA;
+    if (relative > INT16_MAX) {
+        relative = INT16_MAX;
+    } else if (relative < INT16_MIN) {
+        relative = INT16_MIN;
+    }
+    return (int16_t)relative;
+}
+
+
+/*
+ *  Same evaluation as `model_is_pressure_ok`, on the absolute pressure in Pa
+ */
+static uint8_t pressure_within_thresholds(int32_t pressure, uint32_t thresholds) {
+    uint16_t value = (relative_pressure(pressure) / 10) + 1000;
+    return PRESSURE_THRESHOLD_MINIMUM(thresholds) < value && value < PRESSURE_THRESHOLD_MAXIMUM(thresholds);
+}
+
+
+/*
+ *  Called by the sampler owning `channel` with every new filtered value
+ */
+static void channel_statistics_add(sensors_channel_t channel, int32_t sample, uint64_t timestamp) {
+    uint32_t      configuration = atomic_load(&statistics_configuration);
+    uint32_t      channel_bit   = 1U << channel;
+    statistics_t *accumulator   = &channel_statistics[channel].accumulator;
+
+    if (atomic_fetch_and(&statistics_reset_requests, ~channel_bit) & channel_bit) {
+        statistics_reset(accumulator);
+    }
+    if (accumulator->count == 0) {
+        channel_statistics[channel].window_start = timestamp;
+    }
+
+    statistics_add(accumulator, sample);
+
+    if (STATISTICS_RESET_ON_READ(configuration)) {
+        seqlock_publish(&statistics_locks[channel], statistics_published[channel], accumulator,
+                        sizeof(*accumulator));
+    } else if (timestamp - channel_statistics[channel].window_start >= STATISTICS_WINDOW_US(configuration)) {
+        seqlock_publish(&statistics_locks[channel], statistics_published[channel], accumulator,
+                        sizeof(*accumulator));
+        statistics_reset(accumulator);
+    }
+}
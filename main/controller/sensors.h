@@ -3,11 +3,47 @@
 
 
 #include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "timing.h"
+#include "statistics.h"
 
 
-void    sensors_init(uint8_t pressure, uint8_t temperature_humidity);
-void    sensors_read(double *temperature, double *pressure, double *humidity);
-uint8_t sensors_get_errors(void);
+#define SENSORS_NUM_CHANNELS 3
+#define SENSORS_NUM_DEVICES  2
+
+
+typedef enum {
+    SENSORS_CHANNEL_PRESSURE = 0,
+    SENSORS_CHANNEL_TEMPERATURE,
+    SENSORS_CHANNEL_HUMIDITY,
+} sensors_channel_t;
+
+
+typedef enum {
+    SENSORS_DEVICE_MS5837 = 0,
+    SENSORS_DEVICE_SHTC3,
+} sensors_device_t;
+
+
+void     sensors_init(uint8_t pressure, uint8_t temperature_humidity);
+void     sensors_read(int16_t *temperature, int16_t *pressure, int16_t *humidity);
+uint8_t  sensors_get_errors(void);
+uint16_t sensors_get_pressure_sample_rate(void);
+uint16_t sensors_get_pressure_rejected_samples(void);
+int16_t  sensors_get_pressure_slope(void);
+void     sensors_set_pressure_sampling(uint16_t osr, uint16_t window, uint16_t period);
+void     sensors_set_filter(sensors_channel_t channel, uint8_t type);
+void     sensors_get_timing(sensors_device_t device, timing_summary_t *summary);
+uint64_t sensors_get_sample_timestamp(sensors_device_t device);
+uint32_t sensors_get_overruns(sensors_device_t device);
+void     sensors_set_pressure_thresholds(uint16_t minimum, uint16_t maximum);
+void     sensors_set_threshold_notification(EventGroupHandle_t event_group, EventBits_t bits);
+void     sensors_get_threshold_crossing(uint64_t *sample, uint64_t *detection);
+void     sensors_set_statistics(uint16_t window, uint8_t reset_on_read);
+void     sensors_get_statistics(sensors_channel_t channel, statistics_summary_t *summary);
+void     sensors_reset_statistics(void);
 
 
 #endif
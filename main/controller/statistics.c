@@ -0,0 +1,84 @@
+#include <stdint.h>
+#include <string.h>
+#include "statistics.h"
+
+
+static uint32_t isqrt64(uint64_t value);
+
+
+void statistics_reset(statistics_t *statistics) {
+    memset(statistics, 0, sizeof(*statistics));
+}
+
+
+void statistics_add(statistics_t *statistics, int32_t sample) {
+    if (statistics->count == 0) {
+        statistics->origin = sample;
+        statistics->min    = sample;
+        statistics->max    = sample;
+    } else if (sample < statistics->min) {
+        statistics->min = sample;
+    } else if (sample > statistics->max) {
+        statistics->max = sample;
+    }
+
+    if (statistics->count >= STATISTICS_MAX_COUNT) {
+        return;
+    }
+
+    int64_t deviation = (int64_t)sample - statistics->origin;
+    statistics->sum += deviation;
+    statistics->sum_squares += deviation * deviation;
+    statistics->count++;
+}
+
+
+/*
+ *  Mean is rounded to the nearest integer, the standard deviation is the population one
+ */
+void statistics_summarize(const statistics_t *statistics, statistics_summary_t *summary) {
+    memset(summary, 0, sizeof(*summary));
+    if (statistics->count == 0) {
+        return;
+    }
+
+    int64_t n    = statistics->count;
+    int64_t sum  = statistics->sum;
+    int64_t half = sum >= 0 ? n / 2 : -(n / 2);
+
+    summary->count = statistics->count;
+    summary->min   = statistics->min;
+    summary->max   = statistics->max;
+    summary->mean  = (int32_t)(statistics->origin + (sum + half) / n);
+
+    /*
+     *  n * variance = sum(d^2) - sum(d)^2 / n, with sum(d) = q * n + r expanded so that no product exceeds
+     *  n * max(d)^2, i.e. 2^62 with |d| < 2^16 and n <= 2^30
+     */
+    int64_t q          = sum / n;
+    int64_t r          = sum % n;
+    int64_t deviations = statistics->sum_squares - q * q * n - 2 * q * r - (r * r) / n;
+    summary->stddev    = deviations > 0 ? (int32_t)isqrt64((uint64_t)(deviations / n)) : 0;
+}
+
+
+static uint32_t isqrt64(uint64_t value) {
+    uint64_t result = 0;
+    uint64_t bit    = 1ULL << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+
+    while (bit != 0) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)result;
+}
@@ -0,0 +1,42 @@
+#ifndef STATISTICS_H_INCLUDED
+#define STATISTICS_H_INCLUDED
+
+
+#include <stdint.h>
+
+
+// The sums stop growing at this count, so they fit in 64 bits for samples in the int16 range
+#define STATISTICS_MAX_COUNT (1UL << 30)
+
+
+/*
+ *  Single pass statistics over integer samples in the int16 range.
+ *  Sums are kept in 64 bit integers relative to the first sample (shifted data), so the variance does not suffer
+ *  from the cancellation of the naive sum of squares, without any floating point. Past STATISTICS_MAX_COUNT
+ *  samples only the minimum and the maximum are updated.
+ */
+typedef struct {
+    uint32_t count;
+    int32_t  origin;
+    int32_t  min;
+    int32_t  max;
+    int64_t  sum;
+    int64_t  sum_squares;
+} statistics_t;
+
+
+typedef struct {
+    uint32_t count;
+    int32_t  min;
+    int32_t  max;
+    int32_t  mean;
+    int32_t  stddev;
+} statistics_summary_t;
+
+
+void statistics_reset(statistics_t *statistics);
+void statistics_add(statistics_t *statistics, int32_t sample);
+void statistics_summarize(const statistics_t *statistics, statistics_summary_t *summary);
+
+
+#endif
@@ -0,0 +1,69 @@
+#include <stdint.h>
+#include <string.h>
+#include "utils/histogram.h"
+#include "timing.h"
+
+
+static uint32_t percentile(const timing_t *timing, uint32_t permille);
+
+
+void timing_init(timing_t *timing, uint64_t now) {
+    memset(timing, 0, sizeof(*timing));
+    timing->window_start   = now;
+    timing->interval_min   = UINT32_MAX;
+    timing->conversion_min = UINT32_MAX;
+}
+
+
+void timing_add_sample(timing_t *timing, uint64_t timestamp, uint32_t conversion) {
+    if (timing->last_timestamp != 0) {
+        uint64_t elapsed  = timestamp - timing->last_timestamp;
+        uint32_t interval = elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+
+        if (interval < timing->interval_min) {
+            timing->interval_min = interval;
+        }
+        if (interval > timing->interval_max) {
+            timing->interval_max = interval;
+        }
+        timing->histogram[histogram_bin(interval, TIMING_HISTOGRAM_BINS)]++;
+    }
+
+    if (conversion < timing->conversion_min) {
+        timing->conversion_min = conversion;
+    }
+    if (conversion > timing->conversion_max) {
+        timing->conversion_max = conversion;
+    }
+
+    timing->last_timestamp = timestamp;
+    timing->samples++;
+}
+
+
+/*
+ *  Closes the current window, filling `summary`, and starts a new one.
+ *  The last timestamp is kept so the first interval of the new window is not lost.
+ */
+void timing_summarize(timing_t *timing, uint64_t now, timing_summary_t *summary) {
+    uint64_t elapsed = now - timing->window_start;
+
+    summary->samples        = timing->samples;
+    summary->rate           = elapsed > 0 ? (uint32_t)(((uint64_t)timing->samples * 10000000ULL) / elapsed) : 0;
+    summary->interval_min   = timing->interval_min == UINT32_MAX ? 0 : timing->interval_min;
+    summary->interval_max   = timing->interval_max;
+    summary->interval_p50   = percentile(timing, 500);
+    summary->interval_p99   = percentile(timing, 990);
+    summary->conversion_min = timing->conversion_min == UINT32_MAX ? 0 : timing->conversion_min;
+    summary->conversion_max = timing->conversion_max;
+
+    uint64_t last_timestamp = timing->last_timestamp;
+    timing_init(timing, now);
+    timing->last_timestamp = last_timestamp;
+}
+
+
+static uint32_t percentile(const timing_t *timing, uint32_t permille) {
+    return histogram_percentile(timing->histogram, TIMING_HISTOGRAM_BINS, permille, timing->interval_min,
+                                timing->interval_max);
+}
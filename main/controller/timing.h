@@ -0,0 +1,48 @@
+#ifndef TIMING_H_INCLUDED
+#define TIMING_H_INCLUDED
+
+
+#include <stdint.h>
+
+
+#define TIMING_HISTOGRAM_BINS 64
+
+
+/*
+ *  Statistics over the samples of one window, all times in microseconds
+ */
+typedef struct {
+    uint32_t samples;
+    uint32_t rate;     // Achieved sample rate in tenths of Hz
+    uint32_t interval_min;
+    uint32_t interval_max;
+    uint32_t interval_p50;
+    uint32_t interval_p99;
+    uint32_t conversion_min;
+    uint32_t conversion_max;
+} timing_summary_t;
+
+
+/*
+ *  Accumulator for the timing of a sampler.
+ *  Inter-sample intervals are counted in a logarithmic histogram (see utils/histogram.h, up to about 4 s),
+ *  so percentiles are estimated in O(1) memory with a resolution of about 20%.
+ */
+typedef struct {
+    uint64_t window_start;
+    uint64_t last_timestamp;
+    uint32_t samples;
+    uint32_t interval_min;
+    uint32_t interval_max;
+    uint32_t conversion_min;
+    uint32_t conversion_max;
+    uint32_t histogram[TIMING_HISTOGRAM_BINS];
+} timing_t;
+
+
+void timing_init(timing_t *timing, uint64_t now);
+void timing_add_sample(timing_t *timing, uint64_t timestamp, uint32_t conversion);
+void timing_summarize(timing_t *timing, uint64_t now, timing_summary_t *summary);
+
+
+#endif
@@ -35,7 +35,7 @@ void app_main(void) {
 
     ESP_LOGI(TAG, "Begin main loop");
     for (;;) {
+        // Blocks until there is something to do
         controller_manage(&model);
-        vTaskDelay(pdMS_TO_TICKS(1));
     }
 }
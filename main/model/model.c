@@ -8,25 +8,85 @@
 
 
 static uint8_t valid_mode(uint16_t mode);
+static void    pack_message(uint16_t *registers, const char *string);
 
 
 void model_init(model_t *pmodel) {
     pmodel->sem = xSemaphoreCreateMutexStatic(&pmodel->semaphore_buffer);
 
-    pmodel->address       = EASYCONNECT_DEFAULT_MINION_ADDRESS;
-    pmodel->serial_number = EASYCONNECT_DEFAULT_MINION_SERIAL_NUMBER;
-    pmodel->class         = EASYCONNECT_DEFAULT_DEVICE_CLASS;
+    pmodel->data.address       = EASYCONNECT_DEFAULT_MINION_ADDRESS;
+    pmodel->data.serial_number = EASYCONNECT_DEFAULT_MINION_SERIAL_NUMBER;
+    pmodel->data.class         = EASYCONNECT_DEFAULT_DEVICE_CLASS;
 
-    pmodel->minimum_pressure = APP_CONFIG_DEFAULT_MINIMUM_PRESSURE_THRESHOLD;
-    pmodel->maximum_pressure = APP_CONFIG_DEFAULT_MAXIMUM_PRESSURE_THRESHOLD;
-    pmodel->pressure         = 0;
-    pmodel->temperature      = 0;
-    pmodel->humidity         = 0;
+    pmodel->data.minimum_pressure = APP_CONFIG_DEFAULT_MINIMUM_PRESSURE_THRESHOLD;
+    pmodel->data.maximum_pressure = APP_CONFIG_DEFAULT_MAXIMUM_PRESSURE_THRESHOLD;
 
-    pmodel->missing_heartbeat = 0;
+    pmodel->data.pressure_osr         = APP_CONFIG_DEFAULT_PRESSURE_OSR;
+    pmodel->data.pressure_window      = APP_CONFIG_DEFAULT_PRESSURE_WINDOW;
+    pmodel->data.pressure_period      = APP_CONFIG_DEFAULT_PRESSURE_PERIOD_MS;
+    pmodel->data.pressure_slope_alarm = 0;
+    pmodel->data.pressure_filter      = 0;
+    pmodel->data.temperature_filter   = 0;
+    pmodel->data.humidity_filter      = 0;
+    pmodel->data.pressure             = 0;
+    pmodel->data.temperature          = 0;
+    pmodel->data.humidity             = 0;
 
-    memset(pmodel->minimum_pressure_message, 0, sizeof(pmodel->minimum_pressure_message));
-    memset(pmodel->maximum_pressure_message, 0, sizeof(pmodel->maximum_pressure_message));
+    pmodel->data.statistics_window        = APP_CONFIG_DEFAULT_STATISTICS_WINDOW_S;
+    pmodel->data.statistics_reset_on_read = APP_CONFIG_DEFAULT_STATISTICS_RESET_ON_READ;
+
+    pmodel->data.missing_heartbeat = 0;
+
+    memset(pmodel->data.minimum_pressure_message, 0, sizeof(pmodel->data.minimum_pressure_message));
+    memset(pmodel->data.maximum_pressure_message, 0, sizeof(pmodel->data.maximum_pressure_message));
+    memset(pmodel->data.minimum_pressure_message_registers, 0, sizeof(pmodel->data.minimum_pressure_message_registers));
+    memset(pmodel->data.maximum_pressure_message_registers, 0, sizeof(pmodel->data.maximum_pressure_message_registers));
+
+    seqlock_init(&pmodel->snapshot_lock);
+    model_publish_unsafe(pmodel);
+}
+
+
+/*
+ *  Publishes the current state as the new snapshot; must be called with `sem` taken, which also keeps the sequence
+ *  lock single writer
+ */
+void model_publish_unsafe(model_t *pmodel) {
+    seqlock_publish(&pmodel->snapshot_lock, pmodel->snapshots, &pmodel->data, sizeof(pmodel->data));
+    atomic_store_explicit(&pmodel->published_address, pmodel->data.address, memory_order_relaxed);
+}
+
+
+/*
+ *  Copies the last published state without taking the mutex, all fields from the same update
+ */
+void model_get_snapshot(model_t *pmodel, model_snapshot_t *snapshot) {
+    assert(pmodel != NULL);
+    seqlock_read(&pmodel->snapshot_lock, pmodel->snapshots, snapshot, sizeof(*snapshot));
+}
+
+
+/*
+ *  Same address as the last snapshot, read without taking the mutex or copying the whole state
+ */
+uint16_t model_get_published_address(model_t *pmodel) {
+    assert(pmodel != NULL);
+    return atomic_load_explicit(&pmodel->published_address, memory_order_relaxed);
+}
+
+
+/*
+ *  Sensor readings are updated together so no snapshot mixes two different acquisitions
+ */
+void model_set_readings(model_t *pmodel, int16_t temperature, int16_t pressure, int16_t humidity) {
+    assert(pmodel != NULL);
+
+    xSemaphoreTake(pmodel->sem, portMAX_DELAY);
+    pmodel->data.temperature = temperature;
+    pmodel->data.pressure    = pressure;
+    pmodel->data.humidity    = humidity;
+    model_publish_unsafe(pmodel);
+    xSemaphoreGive(pmodel->sem);
 }
 
 
@@ -35,26 +95,31 @@ uint16_t model_get_class(void *arg) {
     model_t *pmodel = arg;
 
     xSemaphoreTake(pmodel->sem, portMAX_DELAY);
-    uint16_t result = (pmodel->class & CLASS_CONFIGURABLE_MASK) | (APP_CONFIG_HARDWARE_MODEL << 12);
+    uint16_t result = model_snapshot_get_class(&pmodel->data);
     xSemaphoreGive(pmodel->sem);
 
     return result;
 }
 
 
+uint16_t model_snapshot_get_class(const model_snapshot_t *snapshot) {
+    return (snapshot->class & CLASS_CONFIGURABLE_MASK) | (APP_CONFIG_HARDWARE_MODEL << 12);
+}
+
+
 int model_set_class(void *arg, uint16_t class, uint16_t *out_class) {
     assert(arg != NULL);
     model_t *pmodel = arg;
 
     uint16_t corrected = class & CLASS_CONFIGURABLE_MASK;
-    uint16_t mode      = CLASS_GET_MODE(corrected | (APP_CONFIG_HARDWARE_MODEL << 12));
 
-    if (valid_mode(mode)) {
+    if (model_is_class_valid(class)) {
         if (out_class != NULL) {
             *out_class = corrected;
         }
         xSemaphoreTake(pmodel->sem, portMAX_DELAY);
-        pmodel->class = corrected;
+        pmodel->data.class = corrected;
+        model_publish_unsafe(pmodel);
         xSemaphoreGive(pmodel->sem);
         return 0;
     } else {
@@ -63,14 +128,18 @@ int model_set_class(void *arg, uint16_t class, uint16_t *out_class) {
 }
 
 
-int model_set_minimum_pressure(model_t *pmodel, uint16_t pressure) {
+int model_set_minimum_pressure(model_t *pmodel, uint16_t pressure, model_pressure_thresholds_cb_t apply) {
     assert(pmodel != NULL);
     int res = 0;
 
     xSemaphoreTake(pmodel->sem, portMAX_DELAY);
     if (pressure >= APP_CONFIG_DEFAULT_MINIMUM_PRESSURE_THRESHOLD &&
         pressure <= APP_CONFIG_DEFAULT_MAXIMUM_PRESSURE_THRESHOLD) {
-        pmodel->minimum_pressure = pressure;
+        pmodel->data.minimum_pressure = pressure;
+        model_publish_unsafe(pmodel);
+        if (apply != NULL) {
+            apply(pmodel->data.minimum_pressure, pmodel->data.maximum_pressure);
+        }
     } else {
         res = -1;
     }
@@ -80,14 +149,18 @@ int model_set_minimum_pressure(model_t *pmodel, uint16_t pressure) {
 }
 
 
-int model_set_maximum_pressure(model_t *pmodel, uint16_t pressure) {
+int model_set_maximum_pressure(model_t *pmodel, uint16_t pressure, model_pressure_thresholds_cb_t apply) {
     assert(pmodel != NULL);
     int res = 0;
 
     xSemaphoreTake(pmodel->sem, portMAX_DELAY);
     if (pressure >= APP_CONFIG_DEFAULT_MINIMUM_PRESSURE_THRESHOLD &&
         pressure <= APP_CONFIG_DEFAULT_MAXIMUM_PRESSURE_THRESHOLD) {
-        pmodel->maximum_pressure = pressure;
+        pmodel->data.maximum_pressure = pressure;
+        model_publish_unsafe(pmodel);
+        if (apply != NULL) {
+            apply(pmodel->data.minimum_pressure, pmodel->data.maximum_pressure);
+        }
     } else {
         res = -1;
     }
@@ -97,31 +170,105 @@ int model_set_maximum_pressure(model_t *pmodel, uint16_t pressure) {
 }
 
 
+int model_set_pressure_osr(model_t *pmodel, uint16_t osr) {
+    assert(pmodel != NULL);
+    int res = 0;
+
+    if (model_is_pressure_osr_valid(osr)) {
+        xSemaphoreTake(pmodel->sem, portMAX_DELAY);
+        pmodel->data.pressure_osr = osr;
+        model_publish_unsafe(pmodel);
+        xSemaphoreGive(pmodel->sem);
+    } else {
+        res = -1;
+    }
+
+    return res;
+}
+
+
+int model_set_pressure_window(model_t *pmodel, uint16_t window) {
+    assert(pmodel != NULL);
+    int res = 0;
+
+    if (model_is_pressure_window_valid(window)) {
+        xSemaphoreTake(pmodel->sem, portMAX_DELAY);
+        pmodel->data.pressure_window = window;
+        model_publish_unsafe(pmodel);
+        xSemaphoreGive(pmodel->sem);
+    } else {
+        res = -1;
+    }
+
+    return res;
+}
+
+
+int model_set_pressure_period(model_t *pmodel, uint16_t period) {
+    assert(pmodel != NULL);
+    int res = 0;
+
+    if (model_is_pressure_period_valid(period)) {
+        xSemaphoreTake(pmodel->sem, portMAX_DELAY);
+        pmodel->data.pressure_period = period;
+        model_publish_unsafe(pmodel);
+        xSemaphoreGive(pmodel->sem);
+    } else {
+        res = -1;
+    }
+
+    return res;
+}
+
+
+int model_set_statistics_window(model_t *pmodel, uint16_t window) {
+    assert(pmodel != NULL);
+    int res = 0;
+
+    if (model_is_statistics_window_valid(window)) {
+        xSemaphoreTake(pmodel->sem, portMAX_DELAY);
+        pmodel->data.statistics_window = window;
+        model_publish_unsafe(pmodel);
+        xSemaphoreGive(pmodel->sem);
+    } else {
+        res = -1;
+    }
+
+    return res;
+}
+
+
 uint8_t model_is_pressure_ok(model_t *pmodel) {
     assert(pmodel != NULL);
     uint8_t res = 0;
 
-    uint16_t pressure = (model_get_pressure(pmodel) / 10) + 1000;
-
     xSemaphoreTake(pmodel->sem, portMAX_DELAY);
-    res = pmodel->minimum_pressure < pressure && pressure < pmodel->maximum_pressure;
+    res = model_snapshot_is_pressure_ok(&pmodel->data);
     xSemaphoreGive(pmodel->sem);
 
     return res;
 }
 
 
+uint8_t model_snapshot_is_pressure_ok(const model_snapshot_t *snapshot) {
+    uint16_t pressure = (snapshot->pressure / 10) + 1000;
+    return snapshot->minimum_pressure < pressure && pressure < snapshot->maximum_pressure;
+}
+
+
 void model_get_minimum_pressure_message(void *args, char *string) {
     model_t *pmodel = args;
     xSemaphoreTake(pmodel->sem, portMAX_DELAY);
-    strcpy(string, pmodel->minimum_pressure_message);
+    strcpy(string, pmodel->data.minimum_pressure_message);
     xSemaphoreGive(pmodel->sem);
 }
 
 
 void model_set_minimum_pressure_message(model_t *pmodel, const char *string) {
     xSemaphoreTake(pmodel->sem, portMAX_DELAY);
-    snprintf(pmodel->minimum_pressure_message, sizeof(pmodel->minimum_pressure_message), "%s", string);
+    snprintf(pmodel->data.minimum_pressure_message, sizeof(pmodel->data.minimum_pressure_message), "%s", string);
+    pack_message(pmodel->data.minimum_pressure_message_registers, pmodel->data.minimum_pressure_message);
+    model_publish_unsafe(pmodel);
     xSemaphoreGive(pmodel->sem);
 }
 
@@ -129,18 +276,69 @@ void model_set_minimum_pressure_message(model_t *pmodel, const char *string) {
 void model_get_maximum_pressure_message(void *args, char *string) {
     model_t *pmodel = args;
     xSemaphoreTake(pmodel->sem, portMAX_DELAY);
-    strcpy(string, pmodel->maximum_pressure_message);
+    strcpy(string, pmodel->data.maximum_pressure_message);
     xSemaphoreGive(pmodel->sem);
 }
 
 
 void model_set_maximum_pressure_message(model_t *pmodel, const char *string) {
     xSemaphoreTake(pmodel->sem, portMAX_DELAY);
-    snprintf(pmodel->maximum_pressure_message, sizeof(pmodel->maximum_pressure_message), "%s", string);
+    snprintf(pmodel->data.maximum_pressure_message, sizeof(pmodel->data.maximum_pressure_message), "%s", string);
+    pack_message(pmodel->data.maximum_pressure_message_registers, pmodel->data.maximum_pressure_message);
+    model_publish_unsafe(pmodel);
     xSemaphoreGive(pmodel->sem);
 }
 
 
+/*
+ *  Two characters per register, first one in the most significant byte; everything past the terminator reads as 0
+ */
+static void pack_message(uint16_t *registers, const char *string) {
+    size_t length = strlen(string);
+
+    for (size_t i = 0; i < EASYCONNECT_MESSAGE_NUM_REGISTERS; i++) {
+        uint8_t high = i * 2 < length ? string[i * 2] : 0;
+        uint8_t low  = i * 2 + 1 < length ? string[i * 2 + 1] : 0;
+        registers[i] = (high << 8) | low;
+    }
+}
+
+
+/*
+ *  Validity checks for the configurable fields, shared by the setters and by whoever needs to reject a value before
+ *  saving anything (e.g. Modbus write checks and multi-argument console commands)
+ */
+uint8_t model_is_class_valid(uint16_t class) {
+    return valid_mode(CLASS_GET_MODE((class & CLASS_CONFIGURABLE_MASK) | (APP_CONFIG_HARDWARE_MODEL << 12)));
+}
+
+
+uint8_t model_is_pressure_osr_valid(uint16_t osr) {
+    // Only powers of two are valid oversampling ratios
+    return osr >= APP_CONFIG_MINIMUM_PRESSURE_OSR && osr <= APP_CONFIG_MAXIMUM_PRESSURE_OSR && (osr & (osr - 1)) == 0;
+}
+
+
+uint8_t model_is_pressure_window_valid(uint16_t window) {
+    return window > 0 && window <= APP_CONFIG_MAXIMUM_PRESSURE_WINDOW;
+}
+
+
+uint8_t model_is_pressure_period_valid(uint16_t period) {
+    return period <= APP_CONFIG_MAXIMUM_PRESSURE_PERIOD_MS;
+}
+
+
+uint8_t model_is_statistics_window_valid(uint16_t window) {
+    return window > 0 && window <= APP_CONFIG_MAXIMUM_STATISTICS_WINDOW_S;
+}
+
+
+uint8_t model_is_statistics_reset_on_read_valid(uint16_t reset_on_read) {
+    return reset_on_read <= 1;
+}
+
+
 static uint8_t valid_mode(uint16_t mode) {
     switch (mode) {
         case DEVICE_MODE_PRESSURE:
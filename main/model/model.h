@@ -4,6 +4,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "easyconnect_interface.h"
+#include "utils/seqlock.h"
 
 
 #define EASYCONNECT_DEFAULT_MINION_ADDRESS       1
@@ -11,37 +12,39 @@
 #define EASYCONNECT_DEFAULT_DEVICE_CLASS         CLASS(DEVICE_MODE_PRESSURE, DEVICE_GROUP_1)
 
 #define GETTER_UNSAFE(name, field)                                                                                     \
-    static inline __attribute__((always_inline)) typeof(((model_t *)0)->field) model_get_##name(model_t *pmodel) {     \
+    static inline __attribute__((always_inline)) typeof(((model_t *)0)->data.field) model_get_##name(                  \
+        model_t *pmodel) {                                                                                             \
         assert(pmodel != NULL);                                                                                        \
-        typeof(((model_t *)0)->field) res = pmodel->field;                                                             \
+        typeof(((model_t *)0)->data.field) res = pmodel->data.field;                                                   \
         return res;                                                                                                    \
     }
 
 #define SETTER_UNSAFE(name, field)                                                                                     \
-    static inline                                                                                                      \
-        __attribute__((always_inline)) void model_set_##name(model_t *pmodel, typeof(((model_t *)0)->field) value) {   \
+    static inline __attribute__((always_inline)) void model_set_##name(model_t *pmodel,                                \
+                                                                       typeof(((model_t *)0)->data.field) value) {     \
         assert(pmodel != NULL);                                                                                        \
-        pmodel->field = value;                                                                                         \
+        pmodel->data.field = value;                                                                                    \
     }
 
 #define GETTER(type, name, field)                                                                                      \
-    static inline __attribute__((always_inline)) typeof(((model_t *)0)->field) model_get_##name(type *arg) {           \
+    static inline __attribute__((always_inline)) typeof(((model_t *)0)->data.field) model_get_##name(type *arg) {      \
         model_t *pmodel = arg;                                                                                         \
         assert(pmodel != NULL);                                                                                        \
         xSemaphoreTake(pmodel->sem, portMAX_DELAY);                                                                    \
-        typeof(((model_t *)0)->field) res = pmodel->field;                                                             \
+        typeof(((model_t *)0)->data.field) res = pmodel->data.field;                                                   \
         xSemaphoreGive(pmodel->sem);                                                                                   \
         return res;                                                                                                    \
     }
 
 
 #define SETTER(type, name, field)                                                                                      \
-    static inline                                                                                                      \
-        __attribute__((always_inline)) void model_set_##name(type *arg, typeof(((model_t *)0)->field) value) {         \
+    static inline __attribute__((always_inline)) void model_set_##name(type *arg,                                      \
+                                                                       typeof(((model_t *)0)->data.field) value) {     \
         model_t *pmodel = arg;                                                                                         \
         assert(pmodel != NULL);                                                                                        \
         xSemaphoreTake(pmodel->sem, portMAX_DELAY);                                                                    \
-        pmodel->field = value;                                                                                         \
+        pmodel->data.field = value;                                                                                    \
+        model_publish_unsafe(pmodel);                                                                                  \
         xSemaphoreGive(pmodel->sem);                                                                                   \
     }
 
@@ -65,9 +68,6 @@
 
 
 typedef struct {
-    StaticSemaphore_t semaphore_buffer;
-    SemaphoreHandle_t sem;
-
     uint8_t missing_heartbeat;
 
     uint16_t address;
@@ -77,25 +77,77 @@ typedef struct {
     uint16_t minimum_pressure;
     uint16_t maximum_pressure;
 
+    uint16_t pressure_osr;             // MS5837 oversampling ratio, 256 to 8192
+    uint16_t pressure_window;          // Number of pressure samples averaged together
+    uint16_t pressure_period;          // Pressure sampling period in ms, 0 for back to back conversions
+    uint16_t pressure_slope_alarm;     // Maximum pressure derivative in 0.1 Pa/s, 0 to disable the alarm
+
+    uint16_t statistics_window;            // Length of the statistics window in seconds
+    uint8_t  statistics_reset_on_read;     // Accumulate statistics until they are read instead of over the window
+
+    uint8_t pressure_filter;
+    uint8_t temperature_filter;
+    uint8_t humidity_filter;
+
     char minimum_pressure_message[EASYCONNECT_MESSAGE_SIZE + 1];
     char maximum_pressure_message[EASYCONNECT_MESSAGE_SIZE + 1];
+    // Same messages packed as they are served over Modbus, two characters per register with the first one in the
+    // most significant byte; updated only when the message changes
+    uint16_t minimum_pressure_message_registers[EASYCONNECT_MESSAGE_NUM_REGISTERS];
+    uint16_t maximum_pressure_message_registers[EASYCONNECT_MESSAGE_NUM_REGISTERS];
 
     int16_t temperature;
     int16_t pressure;     // Pressure value in pascal
     int16_t humidity;
+} model_snapshot_t;
+
+
+typedef struct {
+    StaticSemaphore_t semaphore_buffer;
+    SemaphoreHandle_t sem;
+
+    // Current state, only accessed with `sem` taken
+    model_snapshot_t data;
+
+    // Copy of `data` republished after every change, so readers get a consistent view without taking `sem`
+    seqlock_t        snapshot_lock;
+    model_snapshot_t snapshots[2];
+
+    // Address of the last published state, for the checks that run before a full snapshot is worth taking
+    atomic_uint_least16_t published_address;
 } model_t;
 
 
+// Receives both pressure thresholds after either changes, called with the model mutex taken
+typedef void (*model_pressure_thresholds_cb_t)(uint16_t minimum, uint16_t maximum);
+
+
 void     model_init(model_t *model);
+void     model_publish_unsafe(model_t *pmodel);
+void     model_get_snapshot(model_t *pmodel, model_snapshot_t *snapshot);
+uint16_t model_get_published_address(model_t *pmodel);
+uint8_t  model_snapshot_is_pressure_ok(const model_snapshot_t *snapshot);
+void     model_set_readings(model_t *pmodel, int16_t temperature, int16_t pressure, int16_t humidity);
 uint16_t model_get_class(void *arg);
+uint16_t model_snapshot_get_class(const model_snapshot_t *snapshot);
 int      model_set_class(void *arg, uint16_t class, uint16_t *out_class);
 uint8_t  model_is_pressure_ok(model_t *pmodel);
-int      model_set_minimum_pressure(model_t *pmodel, uint16_t pressure);
-int      model_set_maximum_pressure(model_t *pmodel, uint16_t pressure);
+int      model_set_minimum_pressure(model_t *pmodel, uint16_t pressure, model_pressure_thresholds_cb_t apply);
+int      model_set_maximum_pressure(model_t *pmodel, uint16_t pressure, model_pressure_thresholds_cb_t apply);
+int      model_set_pressure_osr(model_t *pmodel, uint16_t osr);
+int      model_set_pressure_window(model_t *pmodel, uint16_t window);
+int      model_set_pressure_period(model_t *pmodel, uint16_t period);
+int      model_set_statistics_window(model_t *pmodel, uint16_t window);
 void     model_get_minimum_pressure_message(void *args, char *string);
 void     model_set_minimum_pressure_message(model_t *pmodel, const char *string);
 void     model_get_maximum_pressure_message(void *args, char *string);
 void     model_set_maximum_pressure_message(model_t *pmodel, const char *string);
+uint8_t  model_is_class_valid(uint16_t class);
+uint8_t  model_is_pressure_osr_valid(uint16_t osr);
+uint8_t  model_is_pressure_window_valid(uint16_t window);
+uint8_t  model_is_pressure_period_valid(uint16_t period);
+uint8_t  model_is_statistics_window_valid(uint16_t window);
+uint8_t  model_is_statistics_reset_on_read_valid(uint16_t reset_on_read);
 
 
 GETTERNSETTER_GENERIC(address, address);
@@ -104,7 +156,16 @@ GETTERNSETTER_GENERIC(pressure, pressure);
 GETTERNSETTER_GENERIC(temperature, temperature);
 GETTERNSETTER_GENERIC(humidity, humidity);
 GETTERNSETTER_GENERIC(missing_heartbeat, missing_heartbeat);
+GETTERNSETTER_GENERIC(pressure_filter, pressure_filter);
+GETTERNSETTER_GENERIC(temperature_filter, temperature_filter);
+GETTERNSETTER_GENERIC(humidity_filter, humidity_filter);
+GETTERNSETTER_GENERIC(pressure_slope_alarm, pressure_slope_alarm);
+GETTERNSETTER_GENERIC(statistics_reset_on_read, statistics_reset_on_read);
 GETTER(model_t, minimum_pressure, minimum_pressure);
 GETTER(model_t, maximum_pressure, maximum_pressure);
+GETTER(model_t, pressure_osr, pressure_osr);
+GETTER(model_t, pressure_window, pressure_window);
+GETTER(model_t, pressure_period, pressure_period);
+GETTER(model_t, statistics_window, statistics_window);
 
 #endif
\ No newline at end of file
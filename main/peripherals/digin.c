@@ -10,20 +10,16 @@
 #include "gel/debounce/debounce.h"
 #include "freertos/semphr.h"
 #include "esp_log.h"
-#include "freertos/timers.h"
-#include "freertos/event_groups.h"
+#include "utils/utils.h"
 #include "digin.h"
 
 
-#define EVENT_NEW_INPUT 0x01
-
-
-static debounce_filter_t  filter;
-static SemaphoreHandle_t  sem;
-static EventGroupHandle_t events;
-
-
-static void periodic_read(TimerHandle_t timer);
+static debounce_filter_t filter;
+static SemaphoreHandle_t sem;
+// First read that differed from the debounced value, and the last edge that went through the filter
+static uint64_t pending_edge_timestamp = 0;
+static uint64_t edge_timestamp         = 0;
+static uint64_t debounce_timestamp     = 0;
 
 
 void digin_init(void) {
@@ -35,17 +31,9 @@ void digin_init(void) {
     io_conf.pull_up_en    = 0;
     gpio_config(&io_conf);
 
-    static StaticEventGroup_t event_group_buffer;
-    events = xEventGroupCreateStatic(&event_group_buffer);
-
     debounce_filter_init(&filter);
     static StaticSemaphore_t semaphore_buffer;
     sem = xSemaphoreCreateMutexStatic(&semaphore_buffer);
-
-    static StaticTimer_t timer_buffer;
-    TimerHandle_t        timer =
-        xTimerCreateStatic("timerInput", pdMS_TO_TICKS(10), pdTRUE, NULL, periodic_read, &timer_buffer);
-    xTimerStart(timer, portMAX_DELAY);
 }
 
 
@@ -61,27 +49,48 @@ int digin_get(digin_t digin) {
 int digin_take_reading(void) {
     unsigned int input = 0;
     input |= !gpio_get_level(HAP_SAFETY);
-    return debounce_filter(&filter, input, 5);
+    uint64_t now = get_micros();
+
+    // Bounces back to the debounced value discard the pending edge
+    if (input == debounce_value(&filter)) {
+        pending_edge_timestamp = 0;
+    } else if (pending_edge_timestamp == 0) {
+        pending_edge_timestamp = now;
+    }
+
+    int res = debounce_filter(&filter, input, 5);
+    if (res) {
+        edge_timestamp         = pending_edge_timestamp != 0 ? pending_edge_timestamp : now;
+        debounce_timestamp     = now;
+        pending_edge_timestamp = 0;
+    }
+    return res;
 }
 
 
-unsigned int digin_get_inputs(void) {
-    return debounce_value(&filter);
+/*
+ *  Timestamps (us) of the GPIO read that first saw the last input change and of the read that completed its debounce
+ */
+void digin_get_timestamps(uint64_t *edge, uint64_t *debounced) {
+    xSemaphoreTake(sem, portMAX_DELAY);
+    *edge      = edge_timestamp;
+    *debounced = debounce_timestamp;
+    xSemaphoreGive(sem);
 }
 
 
-uint8_t digin_is_value_ready(void) {
-    uint8_t res = xEventGroupGetBits(events) & EVENT_NEW_INPUT;
-    xEventGroupClearBits(events, EVENT_NEW_INPUT);
-    return res > 0;
+unsigned int digin_get_inputs(void) {
+    return debounce_value(&filter);
 }
 
 
-static void periodic_read(TimerHandle_t timer) {
-    (void)timer;
+/*
+ *  Samples and debounces the inputs; must be called at a fixed period by the task that acts on them, so the
+ *  debounce time does not depend on lower priority work. Returns 1 when the debounced value changed
+ */
+int digin_sample(void) {
     xSemaphoreTake(sem, portMAX_DELAY);
-    if (digin_take_reading()) {
-        xEventGroupSetBits(events, EVENT_NEW_INPUT);
-    }
+    int res = digin_take_reading();
     xSemaphoreGive(sem);
+    return res;
 }
@@ -12,7 +12,8 @@ typedef enum {
 void         digin_init(void);
 int          digin_get(digin_t digin);
 int          digin_take_reading(void);
+int          digin_sample(void);
 unsigned int digin_get_inputs(void);
-uint8_t      digin_is_value_ready(void);
+void         digin_get_timestamps(uint64_t *edge, uint64_t *debounced);
 
 #endif
\ No newline at end of file
@@ -5,9 +5,22 @@
 #include "i2c_devices/temperature/SHTC3/shtc3.h"
 
 
+#define MS5837_COMMAND_ADC_READ 0x00
+#define MS5837_COMMAND_RESET    0x1E
+#define MS5837_COMMAND_PROM     0xA0
+#define MS5837_NUM_OSR          6
+
+#define SHTC3_COMMAND_SLEEP                  0xB098
+#define SHTC3_COMMAND_MEASURE_LOW_POWER_T_RH 0x609C
+
+
 static void delay_ms(unsigned long ms);
 
 
+// Maximum conversion time for each oversampling ratio (256, 512, ..., 8192), rounded up to the next millisecond
+static const unsigned long ms5837_conversion_time_ms[MS5837_NUM_OSR] = {1, 2, 3, 5, 10, 19};
+
+
 i2c_driver_t press_driver = {
     .device_address = MS5837_DEFAULT_ADDRESS,
     .delay_ms       = delay_ms,
@@ -22,6 +35,86 @@ i2c_driver_t shtc3_driver = {
 };
 
 
+int i2c_devices_ms5837_reset(void) {
+    uint8_t cmd = MS5837_COMMAND_RESET;
+    if (press_driver.i2c_transfer(press_driver.device_address, &cmd, 1, NULL, 0, press_driver.arg)) {
+        return -1;
+    }
+    // Time needed to reload the PROM
+    delay_ms(10);
+    return 0;
+}
+
+
+int i2c_devices_ms5837_read_prom(uint16_t *prom, size_t words) {
+    for (size_t i = 0; i < words; i++) {
+        uint8_t cmd       = MS5837_COMMAND_PROM + i * 2;
+        uint8_t buffer[2] = {0};
+
+        if (press_driver.i2c_transfer(press_driver.device_address, &cmd, 1, buffer, sizeof(buffer),
+                                      press_driver.arg)) {
+            return -1;
+        }
+        prom[i] = ((uint16_t)buffer[0] << 8) | buffer[1];
+    }
+
+    return 0;
+}
+
+
+/*
+ *  Split-phase access to the MS5837: the conversion is started without waiting for it, so the caller can
+ *  yield and collect the result with `i2c_devices_ms5837_read_adc` once the conversion time has elapsed.
+ *  `osr` is the oversampling index, 0 (OSR 256) to 5 (OSR 8192).
+ */
+int i2c_devices_ms5837_start_conversion(uint8_t command, uint8_t osr) {
+    if (osr >= MS5837_NUM_OSR) {
+        return -1;
+    }
+
+    uint8_t cmd = command + osr * 2;
+    return press_driver.i2c_transfer(press_driver.device_address, &cmd, 1, NULL, 0, press_driver.arg);
+}
+
+
+int i2c_devices_ms5837_read_adc(uint32_t *adc) {
+    uint8_t cmd       = MS5837_COMMAND_ADC_READ;
+    uint8_t buffer[3] = {0};
+
+    if (press_driver.i2c_transfer(press_driver.device_address, &cmd, 1, buffer, sizeof(buffer), press_driver.arg)) {
+        return -1;
+    }
+
+    *adc = ((uint32_t)buffer[0] << 16) | ((uint32_t)buffer[1] << 8) | buffer[2];
+    // The sensor answers 0 when the conversion is not finished yet
+    return *adc == 0 ? -1 : 0;
+}
+
+
+unsigned long i2c_devices_ms5837_conversion_time_ms(uint8_t osr) {
+    if (osr >= MS5837_NUM_OSR) {
+        return ms5837_conversion_time_ms[MS5837_NUM_OSR - 1];
+    }
+    return ms5837_conversion_time_ms[osr];
+}
+
+
+int i2c_devices_shtc3_sleep(void) {
+    uint8_t cmd[2] = {SHTC3_COMMAND_SLEEP >> 8, SHTC3_COMMAND_SLEEP & 0xFF};
+    return shtc3_driver.i2c_transfer(shtc3_driver.device_address, cmd, sizeof(cmd), NULL, 0, shtc3_driver.arg);
+}
+
+
+/*
+ *  Low power measurement, temperature first and without clock stretching; the result has the same format as the
+ *  normal one and is read with `shtc3_read_temperature_humidity_measurement`
+ */
+int i2c_devices_shtc3_start_low_power_measurement(void) {
+    uint8_t cmd[2] = {SHTC3_COMMAND_MEASURE_LOW_POWER_T_RH >> 8, SHTC3_COMMAND_MEASURE_LOW_POWER_T_RH & 0xFF};
+    return shtc3_driver.i2c_transfer(shtc3_driver.device_address, cmd, sizeof(cmd), NULL, 0, shtc3_driver.arg);
+}
+
+
 static void delay_ms(unsigned long ms) {
     vTaskDelay(pdMS_TO_TICKS(ms));
 }
\ No newline at end of file
@@ -2,10 +2,27 @@
 #define I2C_DEVICES_H_INCLUDED
 
 
+#include <stdint.h>
+#include <stdlib.h>
 #include "i2c_common/i2c_common.h"
 
 
+#define I2C_DEVICES_MS5837_CONVERT_D1 0x40
+#define I2C_DEVICES_MS5837_CONVERT_D2 0x50
+
+#define I2C_DEVICES_SHTC3_LOW_POWER_MEASUREMENT_PERIOD_MS 1
+
+
 extern i2c_driver_t press_driver;
 extern i2c_driver_t shtc3_driver;
 
-#endif
\ No newline at end of file
+
+int           i2c_devices_ms5837_reset(void);
+int           i2c_devices_ms5837_read_prom(uint16_t *prom, size_t words);
+int           i2c_devices_ms5837_start_conversion(uint8_t command, uint8_t osr);
+int           i2c_devices_ms5837_read_adc(uint32_t *adc);
+unsigned long i2c_devices_ms5837_conversion_time_ms(uint8_t osr);
+int           i2c_devices_shtc3_sleep(void);
+int           i2c_devices_shtc3_start_low_power_measurement(void);
+
+#endif
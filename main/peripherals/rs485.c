@@ -1,13 +1,42 @@
+#include <string.h>
+#include <stddef.h>
 #include <driver/gpio.h>
 #include <driver/uart.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/message_buffer.h"
+#include "config/app_config.h"
+#include "utils/utils.h"
 #include "hardwareprofile.h"
+#include "rtu_framer.h"
+#include "rs485.h"
 
 
 #define MB_PORTNUM 1
 // Timeout threshold for UART = number of symbols (~10 tics) with unchanged
 // state on receive pin
 #define ECHO_READ_TOUT (3)     // 3.5T * 8 = 28 ticks, TOUT=3 -> ~24..33 ticks
-#define MODBUS_TIMEOUT 10
+#define UART_QUEUE_SIZE 10
+#define FRAMES_QUEUED   4     // Room for a burst of back to back frames
+#define READ_CHUNK_SIZE 128
+
+
+// Complete frame as handed over to the reader, prefixed by the time its RX timeout was noticed
+typedef struct {
+    uint64_t timestamp;
+    uint8_t  data[RS485_MAX_FRAME_SIZE];
+} frame_t;
+
+// Each message in the buffer also costs the length word
+#define FRAME_BUFFER_SIZE (FRAMES_QUEUED * (sizeof(frame_t) + sizeof(size_t)))
+
+
+static void uart_event_task(void *args);
+
+
+static QueueHandle_t         uart_queue = NULL;
+static MessageBufferHandle_t frames     = NULL;
 
 
 void rs485_init(int baud_rate) {
@@ -24,14 +53,44 @@ void rs485_init(int baud_rate) {
     ESP_ERROR_CHECK(uart_param_config(MB_PORTNUM, &uart_config));
 
     ESP_ERROR_CHECK(uart_set_pin(MB_PORTNUM, MB_UART_TXD, MB_UART_RXD, MB_DERE, -1));
-    ESP_ERROR_CHECK(uart_driver_install(MB_PORTNUM, 256, 256, 10, NULL, 0));
+    ESP_ERROR_CHECK(uart_driver_install(MB_PORTNUM, 256, 256, UART_QUEUE_SIZE, &uart_queue, 0));
     ESP_ERROR_CHECK(uart_set_mode(MB_PORTNUM, UART_MODE_RS485_HALF_DUPLEX));
     ESP_ERROR_CHECK(uart_set_rx_timeout(MB_PORTNUM, ECHO_READ_TOUT));
+
+    static uint8_t               frame_buffer[FRAME_BUFFER_SIZE];
+    static StaticMessageBuffer_t frame_buffer_struct;
+    frames = xMessageBufferCreateStatic(sizeof(frame_buffer), frame_buffer, &frame_buffer_struct);
+
+    static StaticTask_t task_buffer;
+    static StackType_t  task_stack[APP_CONFIG_BASE_TASK_STACK_SIZE * 4];
+    xTaskCreateStatic(uart_event_task, "UART", sizeof(task_stack) / sizeof(StackType_t), NULL, 2, task_stack,
+                      &task_buffer);
 }
 
 
-int rs485_read(uint8_t *buffer, size_t len) {
-    return uart_read_bytes(MB_PORTNUM, buffer, len, pdMS_TO_TICKS(MODBUS_TIMEOUT));
+/*
+ * Waits up to `timeout` for a complete frame, delimited by the T3.5 idle time on the bus, and copies it to `buffer`.
+ * `timestamp` (optional) receives the time in microseconds when the end of the frame was detected.
+ * Returns the length of the frame, 0 on timeout.
+ */
+int rs485_read_frame(uint8_t *buffer, size_t len, uint64_t *timestamp, TickType_t timeout) {
+    static frame_t frame;
+
+    size_t size = xMessageBufferReceive(frames, &frame, sizeof(frame), timeout);
+    if (size < offsetof(frame_t, data)) {
+        return 0;
+    }
+
+    size_t frame_len = size - offsetof(frame_t, data);
+    if (frame_len > len) {
+        frame_len = len;
+    }
+
+    memcpy(buffer, frame.data, frame_len);
+    if (timestamp != NULL) {
+        *timestamp = frame.timestamp;
+    }
+    return frame_len;
 }
 
 
@@ -42,4 +101,66 @@ int rs485_write(uint8_t *buffer, size_t len) {
 
 void rs485_flush(void) {
     uart_flush_input(MB_PORTNUM);
+}
+
+
+/*
+ * Feeds the received bytes to the RTU framer until the RX timeout marks an idle bus, then hands every frame found
+ * over to the reader. The timeout is measured by the UART in symbol times, the task only sees the bytes in chunks.
+ */
+static void uart_event_task(void *args) {
+    (void)args;
+    static rtu_framer_t framer;
+    static frame_t      frame;
+    static uint8_t      chunk[READ_CHUNK_SIZE];
+    uart_event_t        event;
+
+    rtu_framer_reset(&framer);
+
+    for (;;) {
+        if (xQueueReceive(uart_queue, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        switch (event.type) {
+            case UART_DATA: {
+                size_t remaining = event.size;
+                while (remaining > 0) {
+                    size_t size = remaining < sizeof(chunk) ? remaining : sizeof(chunk);
+                    int    read = uart_read_bytes(MB_PORTNUM, chunk, size, 0);
+                    if (read <= 0) {
+                        break;
+                    }
+                    rtu_framer_feed(&framer, chunk, read);
+                    remaining -= read;
+                }
+
+                if (event.timeout_flag) {
+                    size_t   length    = 0;
+                    uint64_t timestamp = get_micros();
+
+                    rtu_framer_idle(&framer);
+                    while ((length = rtu_framer_pop(&framer, frame.data, sizeof(frame.data))) > 0) {
+                        frame.timestamp = timestamp;
+                        // If the reader is lagging behind the frame is dropped, like a master timeout would do
+                        xMessageBufferSend(frames, &frame, offsetof(frame_t, data) + length, 0);
+                    }
+                }
+                break;
+            }
+
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL:
+                // The data is lost anyway, start over from a clean buffer
+                uart_flush_input(MB_PORTNUM);
+                xQueueReset(uart_queue);
+                rtu_framer_reset(&framer);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    vTaskDelete(NULL);
 }
\ No newline at end of file
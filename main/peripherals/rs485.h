@@ -4,10 +4,15 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "rtu_framer.h"
+
+
+#define RS485_MAX_FRAME_SIZE RTU_FRAMER_MAX_SIZE
 
 
 void rs485_init(int baud_rate);
-int  rs485_read(uint8_t *buffer, size_t len);
+int  rs485_read_frame(uint8_t *buffer, size_t len, uint64_t *timestamp, TickType_t timeout);
 int  rs485_write(uint8_t *buffer, size_t len);
 void rs485_flush(void);
 
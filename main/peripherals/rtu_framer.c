@@ -0,0 +1,237 @@
+#include <stdint.h>
+#include <string.h>
+#include "rtu_framer.h"
+
+
+// Address, function code and CRC
+#define MIN_FRAME_SIZE 4
+#define BUFFER_MASK    (RTU_FRAMER_BUFFER_SIZE - 1)
+
+
+typedef enum {
+    LENGTH_MISMATCH = 0,
+    LENGTH_UNKNOWN,
+    LENGTH_PROVISIONAL,
+    LENGTH_CONFIRMED,
+} length_match_t;
+
+
+static length_match_t match_length(const rtu_framer_t *framer, size_t start, size_t length);
+static void           add_end(rtu_framer_t *framer, size_t end);
+static uint8_t        byte_at(const rtu_framer_t *framer, size_t position);
+static uint16_t       crc_update(uint16_t crc, uint8_t byte);
+
+
+void rtu_framer_reset(rtu_framer_t *framer) {
+    framer->head        = 0;
+    framer->tail        = 0;
+    framer->start       = 0;
+    framer->burst       = 0;
+    framer->crc         = 0xFFFF;
+    framer->burst_crc   = 0xFFFF;
+    framer->overflow    = 0;
+    framer->provisional = 0;
+    framer->first_end   = 0;
+    framer->num_ends    = 0;
+    framer->ready       = 0;
+}
+
+
+/*
+ *  Appends the bytes received so far, updating the CRC one byte at a time. When the ring buffer or the list of frame
+ *  ends is full, or the frame grows past RTU_FRAMER_MAX_SIZE, the rest of the burst is dropped.
+ */
+void rtu_framer_feed(rtu_framer_t *framer, const uint8_t *bytes, size_t len) {
+    for (size_t i = 0; i < len && !framer->overflow; i++) {
+        if (framer->head - framer->tail >= RTU_FRAMER_BUFFER_SIZE ||
+            framer->head - framer->start >= RTU_FRAMER_MAX_SIZE || framer->num_ends >= RTU_FRAMER_MAX_FRAMES) {
+            framer->overflow = 1;
+            break;
+        }
+
+        framer->data[framer->head++ & BUFFER_MASK] = bytes[i];
+        framer->crc                                = crc_update(framer->crc, bytes[i]);
+        framer->burst_crc                          = crc_update(framer->burst_crc, bytes[i]);
+
+        if (framer->provisional) {
+            framer->provisional_crc = crc_update(framer->provisional_crc, bytes[i]);
+            if (framer->provisional_crc == 0 &&
+                match_length(framer, framer->provisional_start, framer->head - framer->provisional_start) ==
+                    LENGTH_CONFIRMED) {
+                // The last split cut a longer frame, which ends here instead
+                framer->num_ends--;
+                framer->start = framer->provisional_start;
+                framer->crc   = 0;
+            }
+        }
+
+        // The CRC computed over a frame including its own CRC leaves a zero residue
+        size_t length = framer->head - framer->start;
+        if (framer->crc != 0 || length < MIN_FRAME_SIZE) {
+            continue;
+        }
+
+        switch (match_length(framer, framer->start, length)) {
+            case LENGTH_CONFIRMED:
+                // Also confirms the provisional ends before it, the frame could not start there otherwise
+                add_end(framer, framer->head);
+                framer->ready       = framer->num_ends;
+                framer->burst       = framer->head;
+                framer->burst_crc   = 0xFFFF;
+                framer->provisional = 0;
+                break;
+
+            case LENGTH_PROVISIONAL:
+            case LENGTH_UNKNOWN:
+                add_end(framer, framer->head);
+                framer->provisional       = 1;
+                framer->provisional_start = framer->start;
+                framer->provisional_crc   = 0;
+                break;
+
+            case LENGTH_MISMATCH:
+                // Zero residue by chance in the middle of the frame
+                continue;
+        }
+
+        framer->start = framer->head;
+        framer->crc   = 0xFFFF;
+    }
+}
+
+
+/*
+ *  To be called when the bus goes idle for T3.5: closes the burst and makes all of its frames available. Trailing
+ *  bytes that do not make a valid frame are returned as the last one, so the parser can report them.
+ */
+void rtu_framer_idle(rtu_framer_t *framer) {
+    if (framer->overflow) {
+        framer->head = framer->start;
+    } else if (framer->num_ends > framer->ready && framer->burst_crc == 0) {
+        // The whole burst is a valid frame by itself, the zero residues found in between were a coincidence
+        framer->num_ends = framer->ready;
+        framer->start    = framer->burst;
+    }
+
+    if (framer->head != framer->start) {
+        add_end(framer, framer->head);
+    }
+
+    framer->ready       = framer->num_ends;
+    framer->start       = framer->head;
+    framer->burst       = framer->head;
+    framer->crc         = 0xFFFF;
+    framer->burst_crc   = 0xFFFF;
+    framer->overflow    = 0;
+    framer->provisional = 0;
+}
+
+
+/*
+ *  Copies the next complete frame to `buffer` and returns its length, 0 when there are none.
+ */
+size_t rtu_framer_pop(rtu_framer_t *framer, uint8_t *buffer, size_t len) {
+    if (framer->ready == 0) {
+        return 0;
+    }
+
+    size_t end        = framer->ends[framer->first_end];
+    framer->first_end = (framer->first_end + 1) % RTU_FRAMER_MAX_FRAMES;
+    framer->num_ends--;
+    framer->ready--;
+
+    size_t length = end - framer->tail;
+    if (length > len) {
+        length = len;
+    }
+
+    size_t offset = framer->tail & BUFFER_MASK;
+    size_t first  = RTU_FRAMER_BUFFER_SIZE - offset;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(buffer, &framer->data[offset], first);
+    memcpy(&buffer[first], framer->data, length - first);
+
+    framer->tail = end;
+    return length;
+}
+
+
+/*
+ *  Checks a zero residue at `length` bytes against the sizes the function code allows for a request and for a
+ *  response. A match with the shorter of the two could still be the middle of the longer one, so it is provisional.
+ */
+static length_match_t match_length(const rtu_framer_t *framer, size_t start, size_t length) {
+    uint8_t function = byte_at(framer, start + 1);
+    size_t  request  = 0;
+    size_t  response = 0;
+
+    if (function & 0x80) {
+        // Exception response: address, function, exception code and CRC
+        request  = 5;
+        response = 5;
+    } else {
+        switch (function) {
+            case 1:
+            case 2:
+            case 3:
+            case 4:
+                request  = 8;
+                response = 5 + byte_at(framer, start + 2);
+                break;
+
+            case 5:
+            case 6:
+                request  = 8;
+                response = 8;
+                break;
+
+            case 15:
+            case 16:
+                // The byte count comes after address, function, starting address and quantity
+                request  = length > 6 ? 9 + byte_at(framer, start + 6) : 0;
+                response = 8;
+                break;
+
+            default:
+                return LENGTH_UNKNOWN;
+        }
+    }
+
+    size_t longest = request > response ? request : response;
+    if (length == longest) {
+        return LENGTH_CONFIRMED;
+    } else if (length == request || length == response) {
+        return LENGTH_PROVISIONAL;
+    } else {
+        return LENGTH_MISMATCH;
+    }
+}
+
+
+static void add_end(rtu_framer_t *framer, size_t end) {
+    framer->ends[(framer->first_end + framer->num_ends) % RTU_FRAMER_MAX_FRAMES] = end;
+    framer->num_ends++;
+}
+
+
+static uint8_t byte_at(const rtu_framer_t *framer, size_t position) {
+    return framer->data[position & BUFFER_MASK];
+}
+
+
+/*
+ *  Modbus CRC16, polynomial 0xA001 (reflected 0x8005)
+ */
+static uint16_t crc_update(uint16_t crc, uint8_t byte) {
+    crc ^= byte;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        if (crc & 1) {
+            crc = (crc >> 1) ^ 0xA001;
+        } else {
+            crc >>= 1;
+        }
+    }
+    return crc;
+}
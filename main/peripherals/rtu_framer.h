@@ -0,0 +1,49 @@
+#ifndef RTU_FRAMER_H_INCLUDED
+#define RTU_FRAMER_H_INCLUDED
+
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+#define RTU_FRAMER_MAX_SIZE    256     // Longest RTU frame allowed by the standard
+#define RTU_FRAMER_BUFFER_SIZE 512     // Must be a power of two, room for the frame being received and the ones before
+#define RTU_FRAMER_MAX_FRAMES  8       // Frame ends remembered until popped, bursts past the limit are dropped
+
+
+/*
+ *  Splits the byte stream received from the bus into RTU frames. The end of a burst is given by the idle time on the
+ *  line (T3.5, measured by the UART), frames sent back to back within a burst are told apart by the CRC residue
+ *  dropping to zero as the bytes arrive. A zero residue is only trusted as a frame end when the length agrees with
+ *  the framing rules of the function code; otherwise the split stays provisional and is undone if the frame it cut
+ *  reaches its announced length with a valid CRC, or if the whole burst turns out to be a single valid frame.
+ *  Positions are free running and wrapped on access to the ring buffer.
+ */
+typedef struct {
+    uint8_t  data[RTU_FRAMER_BUFFER_SIZE];
+    size_t   head;          // Next byte to be written
+    size_t   tail;          // First byte not yet popped
+    size_t   start;         // First byte of the frame being received
+    size_t   burst;         // First byte past the last confirmed frame end
+    uint16_t crc;           // Running from `start`
+    uint16_t burst_crc;     // Running from `burst`
+    uint8_t  overflow;      // Bytes of the frame being received were lost, it is discarded when the bus goes idle
+
+    uint8_t  provisional;     // The last split could have cut a longer frame starting at `provisional_start`
+    size_t   provisional_start;
+    uint16_t provisional_crc;     // Running from `provisional_start`
+
+    size_t ends[RTU_FRAMER_MAX_FRAMES];
+    size_t first_end;
+    size_t num_ends;
+    size_t ready;     // Frames at the front of `ends` that can be popped
+} rtu_framer_t;
+
+
+void   rtu_framer_reset(rtu_framer_t *framer);
+void   rtu_framer_feed(rtu_framer_t *framer, const uint8_t *bytes, size_t len);
+void   rtu_framer_idle(rtu_framer_t *framer);
+size_t rtu_framer_pop(rtu_framer_t *framer, uint8_t *buffer, size_t len);
+
+
+#endif
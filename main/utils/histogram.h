@@ -0,0 +1,69 @@
+#ifndef HISTOGRAM_H_INCLUDED
+#define HISTOGRAM_H_INCLUDED
+
+#include <stdint.h>
+
+
+/*
+ *  Logarithmic histogram of durations in microseconds: four bins per octave starting from 64 us, so percentiles
+ *  are estimated in O(1) memory with a resolution of about 20%.
+ */
+#define HISTOGRAM_FIRST_OCTAVE    6     // Values shorter than 2^6 us all end up in the first bin
+#define HISTOGRAM_BINS_PER_OCTAVE 4
+
+
+static inline uint32_t histogram_bin(uint32_t value, uint32_t bins) {
+    if (value < (1UL << HISTOGRAM_FIRST_OCTAVE)) {
+        return 0;
+    }
+
+    uint32_t octave = 31 - __builtin_clz(value);
+    // The two bits below the most significant one select the bin within the octave
+    uint32_t bin = (octave - HISTOGRAM_FIRST_OCTAVE) * HISTOGRAM_BINS_PER_OCTAVE +
+                   ((value >> (octave - 2)) & (HISTOGRAM_BINS_PER_OCTAVE - 1));
+
+    return bin < bins ? bin : bins - 1;
+}
+
+
+static inline uint32_t histogram_bin_upper_bound(uint32_t bin) {
+    uint32_t octave   = bin / HISTOGRAM_BINS_PER_OCTAVE + HISTOGRAM_FIRST_OCTAVE;
+    uint32_t fraction = bin % HISTOGRAM_BINS_PER_OCTAVE;
+    return ((HISTOGRAM_BINS_PER_OCTAVE + fraction + 1UL) << (octave - 2)) - 1;
+}
+
+
+/*
+ *  Upper bound of the bin holding the requested percentile, clamped to the exact extremes `min` and `max`
+ */
+static inline uint32_t histogram_percentile(const uint32_t *histogram, uint32_t bins, uint32_t permille,
+                                            uint32_t min, uint32_t max) {
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < bins; i++) {
+        total += histogram[i];
+    }
+
+    if (total == 0) {
+        return 0;
+    }
+
+    uint32_t target     = (uint32_t)(((uint64_t)total * permille + 999) / 1000);
+    uint32_t cumulative = 0;
+    for (uint32_t i = 0; i < bins; i++) {
+        cumulative += histogram[i];
+        if (cumulative >= target) {
+            uint32_t value = histogram_bin_upper_bound(i);
+            if (value > max) {
+                value = max;
+            }
+            if (value < min) {
+                value = min;
+            }
+            return value;
+        }
+    }
+
+    return max;
+}
+
+#endif
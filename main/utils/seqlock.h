@@ -0,0 +1,53 @@
+#ifndef SEQLOCK_H_INCLUDED
+#define SEQLOCK_H_INCLUDED
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+
+/*
+ *  Double buffered sequence lock for a single writer and multiple readers.
+ *  The writer always fills the buffer that is not being published and then flips the sequence counter;
+ *  readers copy the published buffer and retry whenever the sequence changed during the copy, i.e. whenever the
+ *  writer published in the meantime, even if the buffer they copied was not the one overwritten.
+ *  Neither side ever blocks, and a reader preempting the writer does not spin because the sequence only changes
+ *  once the spare buffer is complete.
+ *
+ *  The buffers are copied with plain memcpy, so the ordering rests on the fences: the writer fences before the copy
+ *  (the copy cannot be seen before the previous sequence update) and between the copy and the new sequence, the
+ *  reader fences between its copy and the final check. This holds on multicore targets too, not only on the single
+ *  core ESP32-C3.
+ */
+typedef struct {
+    atomic_uint sequence;
+} seqlock_t;
+
+
+static inline void seqlock_init(seqlock_t *lock) {
+    atomic_init(&lock->sequence, 0);
+}
+
+
+static inline void seqlock_publish(seqlock_t *lock, void *buffers, const void *value, size_t size) {
+    unsigned int sequence = atomic_load_explicit(&lock->sequence, memory_order_relaxed);
+    // The buffer being overwritten may be the one a slow reader saw published two updates ago
+    atomic_thread_fence(memory_order_release);
+    memcpy((uint8_t *)buffers + ((sequence + 1) & 1) * size, value, size);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&lock->sequence, sequence + 1, memory_order_relaxed);
+}
+
+
+static inline void seqlock_read(seqlock_t *lock, const void *buffers, void *value, size_t size) {
+    unsigned int sequence = 0;
+    do {
+        sequence = atomic_load_explicit(&lock->sequence, memory_order_acquire);
+        memcpy(value, (const uint8_t *)buffers + (sequence & 1) * size, size);
+        // Pairs with the writer fences: the check below sees any update that touched the copied buffer
+        atomic_thread_fence(memory_order_acquire);
+    } while (atomic_load_explicit(&lock->sequence, memory_order_relaxed) != sequence);
+}
+
+
+#endif
@@ -4,7 +4,9 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/timers.h"
+#include "esp_timer.h"
 
 #define get_millis() ((uint32_t)xTaskGetTickCount() * portTICK_PERIOD_MS)
+#define get_micros() ((uint64_t)esp_timer_get_time())
 
 #endif
\ No newline at end of file
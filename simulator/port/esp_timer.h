@@ -0,0 +1,13 @@
+#ifndef ESP_TIMER_H_INCLUDED
+#define ESP_TIMER_H_INCLUDED
+
+#include <stdint.h>
+#include <time.h>
+
+static inline int64_t esp_timer_get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000LL;
+}
+
+#endif
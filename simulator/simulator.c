@@ -17,10 +17,21 @@ void app_main(void *arg) {
     // view_init(&model);
     controller_init(&model);
 
+    unsigned long total_start = ulGetRunTimeCounterValue();
+    unsigned long idle_start  = ulTaskGetIdleRunTimeCounter();
+
     ESP_LOGI(TAG, "Begin main loop");
     for (;;) {
-        ESP_LOGI(TAG, "Hello simulated world!");
         vTaskDelay(pdMS_TO_TICKS(1000));
+
+        // Share of the last second spent in the idle task
+        unsigned long total = ulGetRunTimeCounterValue();
+        unsigned long idle  = ulTaskGetIdleRunTimeCounter();
+        if (total != total_start) {
+            ESP_LOGI(TAG, "Idle %lu%%", ((idle - idle_start) * 100UL) / (total - total_start));
+        }
+        total_start = total;
+        idle_start  = idle;
     }
 
     vTaskDelete(NULL);
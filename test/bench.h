@@ -0,0 +1,46 @@
+#ifndef BENCH_H_INCLUDED
+#define BENCH_H_INCLUDED
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+#define BENCH_ROUNDS 7
+
+
+// Results are accumulated here so the compiler cannot drop the work being timed
+static volatile uint32_t bench_sink = 0;
+
+
+static inline uint64_t bench_nanoseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+
+/*
+ *  Runs `function` `iterations` times per round and returns the nanoseconds per call of the fastest round, which is
+ *  the one least disturbed by the host
+ */
+static inline double bench_run(void (*function)(void), size_t iterations) {
+    double best = 0;
+
+    for (size_t round = 0; round < BENCH_ROUNDS; round++) {
+        uint64_t start = bench_nanoseconds();
+        for (size_t i = 0; i < iterations; i++) {
+            function();
+        }
+        double elapsed = (double)(bench_nanoseconds() - start) / iterations;
+        if (round == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    return best;
+}
+
+
+#endif
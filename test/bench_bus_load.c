@@ -0,0 +1,164 @@
+/*
+ *  Cost of the frames a device receives on a shared bus of 32 devices polled round robin by the master. Only the
+ *  path that differs is timed: every frame for another device used to be parsed after taking a full snapshot, and is
+ *  now dropped by looking at its address. The device under test is address 1.
+ *  The results are modelled: lightmodbus and the model do not build on the host, so the parser is reduced to the
+ *  CRC and address checks it runs before rejecting a frame, and the model to a snapshot of the same size. Only the
+ *  sequence lock is the firmware code.
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "utils/seqlock.h"
+
+
+#define DEVICES          32
+#define OUR_ADDRESS      1
+#define REGISTERS_POLLED 16
+#define BAUD_RATE        115200
+#define T35_US           1750     // Fixed inter-frame gap above 19200 baud
+#define SNAPSHOT_SIZE    168      // sizeof(model_snapshot_t) on the device
+#define MAX_FRAME_SIZE   (5 + REGISTERS_POLLED * 2)
+
+
+static uint16_t crc(const uint8_t *data, size_t len);
+static size_t   build_frame(uint8_t *frame, const uint8_t *pdu, size_t len);
+
+
+static uint8_t frames[DEVICES * 2][MAX_FRAME_SIZE];
+static size_t  lengths[DEVICES * 2];
+
+static seqlock_t             snapshot_lock;
+static uint8_t               snapshots[2][SNAPSHOT_SIZE];
+static pthread_mutex_t       model_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint16_t              model_address;
+static atomic_uint_least16_t published_address;
+
+
+/*
+ *  What the parser does before it rejects a frame for another device: the CRC over the whole frame, then the address
+ */
+static uint32_t parse(const uint8_t *frame, size_t len, uint16_t address) {
+    if (crc(frame, len) != 0) {
+        return 1;
+    }
+    return frame[0] != address && frame[0] != 0;
+}
+
+
+static uint32_t serve(const uint8_t *frame, size_t len) {
+    uint8_t snapshot[SNAPSHOT_SIZE];
+    seqlock_read(&snapshot_lock, snapshots, snapshot, sizeof(snapshot));
+    return parse(frame, len, snapshot[0]);
+}
+
+
+// Every frame is parsed with a fresh snapshot
+static void cycle_unfiltered(void) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < DEVICES * 2; i++) {
+        sum += serve(frames[i], lengths[i]);
+    }
+    bench_sink += sum;
+}
+
+
+// Frames filtered on the address read with the model mutex
+static void cycle_filtered_mutex(void) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < DEVICES * 2; i++) {
+        pthread_mutex_lock(&model_mutex);
+        uint16_t address = model_address;
+        pthread_mutex_unlock(&model_mutex);
+
+        if (frames[i][0] == address || frames[i][0] == 0) {
+            sum += serve(frames[i], lengths[i]);
+        }
+    }
+    bench_sink += sum;
+}
+
+
+// Frames filtered on the address published with the snapshot
+static void cycle_filtered_atomic(void) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < DEVICES * 2; i++) {
+        uint16_t address = atomic_load_explicit(&published_address, memory_order_relaxed);
+
+        if (frames[i][0] == address || frames[i][0] == 0) {
+            sum += serve(frames[i], lengths[i]);
+        }
+    }
+    bench_sink += sum;
+}
+
+
+int main(void) {
+    size_t bytes = 0;
+
+    // Read REGISTERS_POLLED holding registers from each device, followed by its response
+    for (size_t device = 0; device < DEVICES; device++) {
+        uint8_t request[] = {device + 1, 3, 0, 0, 0, REGISTERS_POLLED};
+        uint8_t response[3 + REGISTERS_POLLED * 2] = {device + 1, 3, REGISTERS_POLLED * 2};
+
+        lengths[device * 2]     = build_frame(frames[device * 2], request, sizeof(request));
+        lengths[device * 2 + 1] = build_frame(frames[device * 2 + 1], response, sizeof(response));
+        bytes += lengths[device * 2] + lengths[device * 2 + 1];
+    }
+
+    uint8_t data[SNAPSHOT_SIZE] = {OUR_ADDRESS};
+    seqlock_init(&snapshot_lock);
+    seqlock_publish(&snapshot_lock, snapshots, data, sizeof(data));
+    model_address = OUR_ADDRESS;
+    atomic_init(&published_address, OUR_ADDRESS);
+
+    // 11 bits per character and the T3.5 gap after each frame
+    double bus_us = bytes * 11 * 1e6 / BAUD_RATE + DEVICES * 2 * T35_US;
+
+    printf("Modelled on host, the parser and the model are stand-ins for lightmodbus and model.c\n");
+    printf("%i devices, %zu frames and %zu bytes per polling cycle, %.1f ms on the bus at %i baud\n", DEVICES,
+           (size_t)DEVICES * 2, bytes, bus_us / 1000, BAUD_RATE);
+
+    struct {
+        const char *name;
+        void (*cycle)(void);
+    } variants[] = {
+        {"parse every frame", cycle_unfiltered},
+        {"filter, mutex address", cycle_filtered_mutex},
+        {"filter, atomic address", cycle_filtered_atomic},
+    };
+
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+        double ns = bench_run(variants[i].cycle, 20000);
+        printf("%-24s %8.0f ns per cycle, %6.1f ns per frame, %.4f%% of the bus time\n", variants[i].name, ns,
+               ns / (DEVICES * 2), ns / 10 / bus_us);
+    }
+
+    return 0;
+}
+
+
+static size_t build_frame(uint8_t *frame, const uint8_t *pdu, size_t len) {
+    memcpy(frame, pdu, len);
+    uint16_t value = crc(frame, len);
+    frame[len]     = value & 0xFF;
+    frame[len + 1] = value >> 8;
+    return len + 2;
+}
+
+
+/*
+ *  Bitwise Modbus CRC16, the same loop lightmodbus runs
+ */
+static uint16_t crc(const uint8_t *data, size_t len) {
+    uint16_t value = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        value ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            value = (value & 1) ? (value >> 1) ^ 0xA001 : value >> 1;
+        }
+    }
+    return value;
+}
@@ -0,0 +1,130 @@
+/*
+ *  Cost and accuracy of the MS5837 compensation, from the raw D1/D2 conversions to the int16 relative pressure of
+ *  the model. The baseline went through the double formulas of the MS5837 driver, in mBar, and converted to Pa
+ *  relative to the standard atmosphere in the controller; compensation.c does the same in int64 with cached
+ *  constants and sensors_read() saturates the result. The double path is replicated from the datasheet formulas of
+ *  the 02BA variant, as the driver computed them.
+ */
+#include <stdio.h>
+#include "bench.h"
+#include "compensation.h"
+
+
+#define NUM_INPUTS             1024UL
+#define STANDARD_ATMOSPHERE_PA 101325L
+
+
+// Datasheet example, the CRC nibble of the first word is found at startup
+static uint16_t prom[COMPENSATION_MS5837_PROM_WORDS] = {0, 46372, 43981, 29059, 27842, 31553, 28165};
+
+static compensation_ms5837_t compensation;
+static uint32_t              temperature_adcs[NUM_INPUTS];
+static uint32_t              pressure_adcs[NUM_INPUTS];
+
+
+/*
+ *  Double first and second order compensation, returns the pressure in mBar
+ */
+__attribute__((noinline)) static double double_calculate(uint32_t temperature_adc, uint32_t pressure_adc) {
+    double delta_temperature = (double)temperature_adc - prom[5] * 256.0;
+    double temp              = 2000.0 + delta_temperature * prom[6] / 8388608.0;
+    double offset            = prom[2] * 131072.0 + (prom[4] * delta_temperature) / 64.0;
+    double sensitivity       = prom[1] * 65536.0 + (prom[3] * delta_temperature) / 128.0;
+
+    if (temp < 2000.0) {
+        double low = (temp - 2000.0) * (temp - 2000.0);
+        offset -= 31.0 * low / 8.0;
+        sensitivity -= 63.0 * low / 32.0;
+    }
+
+    return (pressure_adc * sensitivity / 2097152.0 - offset) / 32768.0 / 100.0;
+}
+
+
+// Conversion in the baseline controller_manage()
+static int16_t double_relative(double pressure) {
+    return (int16_t)((pressure - 1013.25) * 100);
+}
+
+
+// Saturation in sensors_read()
+static int16_t fixed_relative(int32_t pressure) {
+    int32_t relative_pressure = pressure - STANDARD_ATMOSPHERE_PA;
+    if (relative_pressure > INT16_MAX) {
+        relative_pressure = INT16_MAX;
+    } else if (relative_pressure < INT16_MIN) {
+        relative_pressure = INT16_MIN;
+    }
+    return (int16_t)relative_pressure;
+}
+
+
+static void bench_double(void) {
+    for (size_t i = 0; i < NUM_INPUTS; i++) {
+        bench_sink += (uint16_t)double_relative(double_calculate(temperature_adcs[i], pressure_adcs[i]));
+    }
+}
+
+
+static void bench_fixed(void) {
+    for (size_t i = 0; i < NUM_INPUTS; i++) {
+        bench_sink += (uint16_t)fixed_relative(
+            compensation_ms5837_calculate(&compensation, temperature_adcs[i], pressure_adcs[i], NULL));
+    }
+}
+
+
+int main(void) {
+    for (uint16_t crc = 0; crc < 16; crc++) {
+        prom[0] = (uint16_t)(crc << 12);
+        if (compensation_ms5837_init(&compensation, prom) == 0) {
+            break;
+        }
+    }
+
+    int32_t example = compensation_ms5837_calculate(&compensation, 8077636, 6465444, NULL);
+    double  expected = double_calculate(8077636, 6465444) * 100;
+    printf("datasheet example: %li Pa fixed, %.2f Pa double\n", (long)example, expected);
+
+    // From about 0 to 40 C, both sides of the second order correction, and about 700 to 1300 mBar
+    uint32_t seed = 1;
+    for (size_t i = 0; i < NUM_INPUTS; i++) {
+        seed                = seed * 1103515245 + 12345;
+        temperature_adcs[i] = 7480000 + (seed >> 8) % 1190000;
+        seed                = seed * 1103515245 + 12345;
+        pressure_adcs[i]    = 5600000 + (seed >> 8) % 1300000;
+    }
+
+    // Beyond +-327 mBar from the standard atmosphere the baseline cast was undefined, the fixed path saturates
+    int32_t max_difference = 0;
+    size_t  differences    = 0;
+    size_t  out_of_range   = 0;
+    for (size_t i = 0; i < NUM_INPUTS; i++) {
+        int32_t fixed  = compensation_ms5837_calculate(&compensation, temperature_adcs[i], pressure_adcs[i], NULL);
+        double  value  = double_calculate(temperature_adcs[i], pressure_adcs[i]);
+        double  offset = (value - 1013.25) * 100;
+        if (offset > INT16_MAX || offset < INT16_MIN) {
+            out_of_range++;
+            continue;
+        }
+
+        int32_t difference = fixed_relative(fixed) - double_relative(value);
+        if (difference != 0) {
+            differences++;
+        }
+        if (abs(difference) > max_difference) {
+            max_difference = abs(difference);
+        }
+    }
+
+    double double_ns = bench_run(bench_double, 10000) / NUM_INPUTS;
+    double fixed_ns  = bench_run(bench_fixed, 10000) / NUM_INPUTS;
+
+    printf("%-8s %12s\n", "path", "ns / sample");
+    printf("%-8s %12.2f\n", "double", double_ns);
+    printf("%-8s %12.2f\n", "fixed", fixed_ns);
+    printf("%zu of %zu samples in range differ, by at most %li Pa\n", differences, NUM_INPUTS - out_of_range,
+           (long)max_difference);
+    printf("%zu samples out of the int16 range\n", out_of_range);
+    return 0;
+}
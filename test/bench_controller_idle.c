@@ -0,0 +1,399 @@
+/*
+ *  Wake-ups and CPU time of the controller loop, replayed on host threads for a few seconds of a bus where the master
+ *  polls the device every POLL_PERIOD_MS with an 8 byte request.
+ *  - polled: the baseline main loop, controller_manage() followed by a 1 ms delay. Every iteration read the UART
+ *    with the 10 ms Modbus timeout, checked the heartbeat, refreshed the LEDs and took the model mutex for them.
+ *    The input was debounced by a software timer every SAFETY_PERIOD_MS.
+ *  - event: the controller sleeps on an event group set by the LED timer, the UART task wakes up on the driver
+ *    events and feeds the RTU framer, the Modbus task wakes up on complete frames. The safety task samples the input
+ *    every SAFETY_PERIOD_MS in place of the input timer.
+ *  Every task is part of the total.
+ *  The work done on each wake-up is only modelled, so the CPU figures are mostly the cost of waking up on the host.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "rtu_framer.h"
+
+
+#define DURATION_MS       3000
+#define POLL_PERIOD_MS    50
+#define MODBUS_TIMEOUT_MS 10
+#define LED_PERIOD_MS     50     // APP_CONFIG_LED_PERIOD_MS
+#define SAFETY_PERIOD_MS  10     // APP_CONFIG_SAFETY_PERIOD_MS
+#define REFRESH_PERIOD_MS 500
+#define OUR_ADDRESS       1
+
+#define EVENT_STOP        0x01
+#define EVENT_LED_TIMER   0x02
+#define EVENT_UART_DATA   0x04
+#define EVENT_FRAME       0x08
+
+
+typedef enum {
+    TASK_CONTROLLER = 0,
+    TASK_TIMER,
+    TASK_UART,
+    TASK_MODBUS,
+    TASK_SAFETY,
+    NUM_TASKS,
+} task_t;
+
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    uint32_t        bits;
+} events_t;
+
+
+static void     events_init(events_t *events);
+static void     events_set(events_t *events, uint32_t bits);
+static uint32_t events_wait(events_t *events, uint32_t bits, uint64_t timeout_ns);
+static void     sleep_ms(uint64_t ms);
+static void     finish(task_t task);
+static uint16_t crc(const uint8_t *data, size_t len);
+
+
+static const char *task_names[NUM_TASKS] = {"controller", "timer service", "UART", "Modbus", "safety"};
+
+// Bytes received by the UART driver, guarded by the lock of `uart_events`
+static uint8_t  rx_data[1024];
+static size_t   rx_length = 0;
+static events_t uart_events;
+static events_t controller_events;
+static events_t modbus_events;
+
+static pthread_mutex_t model_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t         model_heartbeat_missing = 0;
+
+static uint32_t wakeups[NUM_TASKS];
+static uint64_t cpu_ns[NUM_TASKS];
+static uint32_t served = 0;
+
+
+static uint8_t model_get(void) {
+    pthread_mutex_lock(&model_lock);
+    uint8_t value = model_heartbeat_missing;
+    pthread_mutex_unlock(&model_lock);
+    return value;
+}
+
+
+static void model_set(uint8_t value) {
+    pthread_mutex_lock(&model_lock);
+    model_heartbeat_missing = value;
+    pthread_mutex_unlock(&model_lock);
+}
+
+
+// Blinking patterns of the two LEDs, as leds_communication_manage() and leds_activity_manage()
+static void leds_manage(uint64_t now, uint8_t communication, uint8_t pressure, uint8_t signal) {
+    bench_sink += (communication ? (now / 500) % 2 : (now / 100) % 2) + (pressure && signal ? 1 : (now / 250) % 2);
+}
+
+
+static void serve(const uint8_t *buffer, size_t len) {
+    if (len >= 4 && crc(buffer, len) == 0 && buffer[0] == OUR_ADDRESS) {
+        __atomic_add_fetch(&served, 1, __ATOMIC_RELAXED);
+        model_set(0);
+    }
+}
+
+
+/*
+ *  uart_read_bytes() for 256 bytes returns when they have all been received or when the timeout expires
+ */
+static size_t uart_read_bytes(uint8_t *buffer, size_t len, uint64_t timeout_ns) {
+    events_wait(&uart_events, EVENT_STOP, timeout_ns);
+
+    pthread_mutex_lock(&uart_events.lock);
+    if (len > rx_length) {
+        len = rx_length;
+    }
+    memcpy(buffer, rx_data, len);
+    memmove(rx_data, &rx_data[len], rx_length - len);
+    rx_length -= len;
+    pthread_mutex_unlock(&uart_events.lock);
+    return len;
+}
+
+
+static void *polled_controller_task(void *args) {
+    (void)args;
+    uint8_t  buffer[256];
+    uint64_t timestamp = 0;
+
+    while (!(events_wait(&controller_events, EVENT_STOP, 0) & EVENT_STOP)) {
+        // minion_manage(), blocked in the read until the timeout
+        size_t len = uart_read_bytes(buffer, sizeof(buffer), MODBUS_TIMEOUT_MS * 1000000ULL);
+        wakeups[TASK_CONTROLLER]++;
+        serve(buffer, len);
+        uint8_t missing_heartbeat = model_get();
+
+        uint64_t now = bench_nanoseconds() / 1000000ULL;
+        if (now - timestamp >= REFRESH_PERIOD_MS) {
+            model_set(missing_heartbeat);
+            timestamp = now;
+        }
+
+        // The heartbeat and both safety conditions were read from the model on every iteration for the LEDs
+        leds_manage(now, !model_get(), model_get(), model_get());
+
+        sleep_ms(1);
+        wakeups[TASK_CONTROLLER]++;
+    }
+
+    finish(TASK_CONTROLLER);
+    return NULL;
+}
+
+
+// The timerInput callback of digin.c, which took the input mutex on every period
+static void *polled_input_timer_task(void *args) {
+    (void)args;
+
+    while (!(events_wait(&controller_events, EVENT_STOP, SAFETY_PERIOD_MS * 1000000ULL) & EVENT_STOP)) {
+        wakeups[TASK_TIMER]++;
+        pthread_mutex_lock(&model_lock);
+        bench_sink++;
+        pthread_mutex_unlock(&model_lock);
+    }
+
+    finish(TASK_TIMER);
+    return NULL;
+}
+
+
+static void *event_controller_task(void *args) {
+    (void)args;
+
+    while (!(events_wait(&controller_events, EVENT_STOP | EVENT_LED_TIMER, UINT64_MAX) & EVENT_STOP)) {
+        wakeups[TASK_CONTROLLER]++;
+        // safety_get_status() is a single atomic load
+        leds_manage(bench_nanoseconds() / 1000000ULL, 1, 1, 1);
+    }
+
+    finish(TASK_CONTROLLER);
+    return NULL;
+}
+
+
+static void *event_timer_task(void *args) {
+    (void)args;
+
+    while (!(events_wait(&controller_events, EVENT_STOP, LED_PERIOD_MS * 1000000ULL) & EVENT_STOP)) {
+        wakeups[TASK_TIMER]++;
+        events_set(&controller_events, EVENT_LED_TIMER);
+    }
+
+    finish(TASK_TIMER);
+    return NULL;
+}
+
+
+// Complete frames handed over to the Modbus task
+static uint8_t frame[RTU_FRAMER_MAX_SIZE];
+static size_t  frame_length = 0;
+
+
+static void *event_uart_task(void *args) {
+    (void)args;
+    static rtu_framer_t framer;
+    uint8_t             chunk[128];
+
+    rtu_framer_reset(&framer);
+    while (!(events_wait(&uart_events, EVENT_STOP | EVENT_UART_DATA, UINT64_MAX) & EVENT_STOP)) {
+        wakeups[TASK_UART]++;
+
+        // Requests are shorter than the RX FIFO threshold, so every event comes with the RX timeout flag
+        size_t read = 0;
+        while ((read = uart_read_bytes(chunk, sizeof(chunk), 0)) > 0) {
+            rtu_framer_feed(&framer, chunk, read);
+        }
+        rtu_framer_idle(&framer);
+
+        pthread_mutex_lock(&modbus_events.lock);
+        frame_length = rtu_framer_pop(&framer, frame, sizeof(frame));
+        pthread_mutex_unlock(&modbus_events.lock);
+        if (frame_length > 0) {
+            events_set(&modbus_events, EVENT_FRAME);
+        }
+    }
+
+    finish(TASK_UART);
+    return NULL;
+}
+
+
+static void *event_modbus_task(void *args) {
+    (void)args;
+    uint8_t request[RTU_FRAMER_MAX_SIZE];
+
+    while (!(events_wait(&modbus_events, EVENT_STOP | EVENT_FRAME, UINT64_MAX) & EVENT_STOP)) {
+        wakeups[TASK_MODBUS]++;
+
+        pthread_mutex_lock(&modbus_events.lock);
+        size_t len = frame_length;
+        memcpy(request, frame, len);
+        pthread_mutex_unlock(&modbus_events.lock);
+        serve(request, len);
+    }
+
+    finish(TASK_MODBUS);
+    return NULL;
+}
+
+
+static void *event_safety_task(void *args) {
+    (void)args;
+
+    while (!(events_wait(&controller_events, EVENT_STOP, SAFETY_PERIOD_MS * 1000000ULL) & EVENT_STOP)) {
+        wakeups[TASK_SAFETY]++;
+        model_set(model_get());
+    }
+
+    finish(TASK_SAFETY);
+    return NULL;
+}
+
+
+/*
+ *  Sends a request to the device every POLL_PERIOD_MS for DURATION_MS, then stops the tasks
+ */
+static void run(const char *name, void *(*tasks[])(void *), size_t num_tasks, uint8_t notify) {
+    pthread_t threads[NUM_TASKS];
+    uint8_t   request[8] = {OUR_ADDRESS, 3, 0x01, 0x00, 0, 8};
+    uint16_t  value      = crc(request, 6);
+    request[6]           = value & 0xFF;
+    request[7]           = value >> 8;
+
+    events_init(&uart_events);
+    events_init(&controller_events);
+    events_init(&modbus_events);
+    memset(wakeups, 0, sizeof(wakeups));
+    memset(cpu_ns, 0, sizeof(cpu_ns));
+    rx_length = 0;
+    served    = 0;
+
+    for (size_t i = 0; i < num_tasks; i++) {
+        pthread_create(&threads[i], NULL, tasks[i], NULL);
+    }
+
+    uint32_t requests = 0;
+    for (uint64_t elapsed = 0; elapsed < DURATION_MS; elapsed += POLL_PERIOD_MS) {
+        pthread_mutex_lock(&uart_events.lock);
+        memcpy(&rx_data[rx_length], request, sizeof(request));
+        rx_length += sizeof(request);
+        pthread_mutex_unlock(&uart_events.lock);
+        if (notify) {
+            events_set(&uart_events, EVENT_UART_DATA);
+        }
+        requests++;
+
+        sleep_ms(POLL_PERIOD_MS);
+    }
+
+    events_set(&uart_events, EVENT_STOP);
+    events_set(&controller_events, EVENT_STOP);
+    events_set(&modbus_events, EVENT_STOP);
+    for (size_t i = 0; i < num_tasks; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    uint32_t total_wakeups = 0;
+    uint64_t total_cpu_ns  = 0;
+    printf("%s, %u/%u requests served\n", name, served, requests);
+    for (size_t i = 0; i < NUM_TASKS; i++) {
+        if (wakeups[i] > 0) {
+            printf("  %-14s %8.1f wake-ups/s %8.1f us/s\n", task_names[i], wakeups[i] * 1000.0 / DURATION_MS,
+                   cpu_ns[i] / (double)DURATION_MS);
+            total_wakeups += wakeups[i];
+            total_cpu_ns += cpu_ns[i];
+        }
+    }
+    printf("  %-14s %8.1f wake-ups/s %8.1f us/s (%.3f%% busy)\n", "loop total", total_wakeups * 1000.0 / DURATION_MS,
+           total_cpu_ns / (double)DURATION_MS, total_cpu_ns / (DURATION_MS * 10000.0));
+}
+
+
+int main(void) {
+    void *(*polled[])(void *) = {polled_controller_task, polled_input_timer_task};
+    void *(*event[])(void *)  = {event_controller_task, event_timer_task, event_uart_task, event_modbus_task,
+                                 event_safety_task};
+
+    run("polled (controller_manage and a 1 ms delay, input timer)", polled, 2, 0);
+    run("event (LED timer, UART, Modbus and safety tasks)", event, 5, 1);
+    return 0;
+}
+
+
+static void events_init(events_t *events) {
+    // Timeouts are measured on the monotonic clock
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_mutex_init(&events->lock, NULL);
+    pthread_cond_init(&events->cond, &attributes);
+    events->bits = 0;
+}
+
+
+static void events_set(events_t *events, uint32_t bits) {
+    pthread_mutex_lock(&events->lock);
+    events->bits |= bits;
+    pthread_cond_broadcast(&events->cond);
+    pthread_mutex_unlock(&events->lock);
+}
+
+
+/*
+ *  Waits up to `timeout_ns` for any of `bits` and clears them, except EVENT_STOP which stays set for all the tasks
+ */
+static uint32_t events_wait(events_t *events, uint32_t bits, uint64_t timeout_ns) {
+    uint64_t        deadline = timeout_ns == UINT64_MAX ? UINT64_MAX : bench_nanoseconds() + timeout_ns;
+    struct timespec limit    = {.tv_sec = deadline / 1000000000ULL, .tv_nsec = deadline % 1000000000ULL};
+
+    pthread_mutex_lock(&events->lock);
+    while (!(events->bits & bits) && timeout_ns > 0) {
+        if (deadline == UINT64_MAX) {
+            pthread_cond_wait(&events->cond, &events->lock);
+        } else if (pthread_cond_timedwait(&events->cond, &events->lock, &limit) != 0) {
+            break;
+        }
+    }
+    uint32_t result = events->bits & bits;
+    events->bits &= ~(bits & ~EVENT_STOP);
+    pthread_mutex_unlock(&events->lock);
+    return result;
+}
+
+
+static void sleep_ms(uint64_t ms) {
+    struct timespec delay = {.tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L};
+    nanosleep(&delay, NULL);
+}
+
+
+// CPU time is only known by the thread itself
+static void finish(task_t task) {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    cpu_ns[task] = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+
+/*
+ *  Bitwise Modbus CRC16, the same loop lightmodbus runs
+ */
+static uint16_t crc(const uint8_t *data, size_t len) {
+    uint16_t value = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        value ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            value = (value & 1) ? (value >> 1) ^ 0xA001 : value >> 1;
+        }
+    }
+    return value;
+}
@@ -0,0 +1,366 @@
+/*
+ *  Cost of serving holding register reads through the switch in the lightmodbus register callback, called twice per
+ *  register (check and read) as the generic FC3 parser does, against the bulk read over the descriptor table that
+ *  replaced it. Both run on the register map of the device, with the values coming from a snapshot and from
+ *  functions of other modules, as in minion.c.
+ *  The results are modelled: minion.c depends on lightmodbus, FreeRTOS and ESP-IDF, which do not build on the host,
+ *  so both implementations are transcribed here rather than linked. They need to be kept in step with minion.c.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+
+
+#define MESSAGE_NUM_REGISTERS 16
+#define REGISTER_ADDRESS      0
+#define REGISTER_FIRMWARE     1
+#define REGISTER_CLASS        2
+#define REGISTER_SERIAL_1     3
+#define REGISTER_SERIAL_2     4
+#define REGISTER_ALARMS       5
+#define REGISTER_STATE        6
+#define REGISTER_MINIMUM_MSG  64
+#define REGISTER_MAXIMUM_MSG  (REGISTER_MINIMUM_MSG + MESSAGE_NUM_REGISTERS)
+#define CUSTOM_START          256
+#define REGISTER_PRESSURE     (CUSTOM_START + 0)
+#define REGISTER_TEMPERATURE  (CUSTOM_START + 1)
+#define REGISTER_HUMIDITY     (CUSTOM_START + 2)
+#define REGISTER_OSR          (CUSTOM_START + 3)
+#define REGISTER_WINDOW       (CUSTOM_START + 4)
+#define REGISTER_FILTER       (CUSTOM_START + 5)
+#define REGISTER_REJECTED     (CUSTOM_START + 8)
+#define REGISTER_CAPTURE      (CUSTOM_START + 9)
+#define REGISTER_CAPTURE_DATA (CUSTOM_START + 13)
+#define REGISTER_TIMING       (CUSTOM_START + 133)
+#define REGISTER_PERIOD       (CUSTOM_START + 165)
+#define REGISTER_OVERRUNS     (CUSTOM_START + 166)
+#define REGISTER_SLOPE        (CUSTOM_START + 168)
+#define REGISTER_SLOPE_ALARM  (CUSTOM_START + 169)
+#define REGISTER_STATS_WINDOW (CUSTOM_START + 170)
+#define REGISTER_STATS_RESET  (CUSTOM_START + 171)
+#define REGISTER_STATISTICS   (CUSTOM_START + 172)
+#define REGISTER_LATENCY      (CUSTOM_START + 190)
+#define REGISTERS_NUM         (REGISTER_LATENCY + 32)
+#define MAX_READ_REGISTERS    125
+
+#define ACCESS_READ 0x01
+
+#define SNAPSHOT_READER(field)                                                                                         \
+    static uint16_t read_##field(const snapshot_t *snapshot, uint16_t offset) {                                        \
+        (void)offset;                                                                                                  \
+        return (uint16_t)snapshot->field;                                                                              \
+    }
+#define REGISTERS(first, last, reader) [(first)...(last)] = {.access = ACCESS_READ, .base = (first), .read = (reader)}
+#define REGISTER(index, reader)        REGISTERS(index, index, reader)
+
+
+typedef struct {
+    uint16_t address;
+    uint16_t class;
+    uint32_t serial_number;
+    uint16_t pressure_osr;
+    uint16_t pressure_window;
+    uint16_t pressure_period;
+    uint16_t pressure_slope_alarm;
+    uint16_t statistics_window;
+    uint8_t  statistics_reset_on_read;
+    uint8_t  filters[3];
+    uint16_t minimum_message[MESSAGE_NUM_REGISTERS];
+    uint16_t maximum_message[MESSAGE_NUM_REGISTERS];
+    int16_t  temperature;
+    int16_t  pressure;
+    int16_t  humidity;
+} snapshot_t;
+
+typedef struct {
+    uint8_t  access;
+    uint16_t base;
+    uint16_t (*read)(const snapshot_t *snapshot, uint16_t offset);
+} descriptor_t;
+
+typedef enum { QUERY_R_CHECK, QUERY_R } query_t;
+
+
+static snapshot_t snapshot = {.address = 1, .class = 0x101, .serial_number = 0x12345678};
+static uint16_t   other_module[256];
+
+
+// Values owned by other modules, behind a call as on the device
+__attribute__((noinline)) static uint16_t module_value(uint16_t index) {
+    return other_module[index & 0xFF];
+}
+
+
+/*
+ *  Old register callback, only the holding register read path
+ */
+__attribute__((noinline)) static int switch_callback(query_t query, uint16_t index, uint16_t *value) {
+    *value = 0;
+    if (query == QUERY_R_CHECK) {
+        return 0;
+    }
+
+    switch (index) {
+        case REGISTER_ADDRESS:
+            *value = snapshot.address;
+            break;
+        case REGISTER_FIRMWARE:
+            *value = 0x0102;
+            break;
+        case REGISTER_CLASS:
+            *value = snapshot.class;
+            break;
+        case REGISTER_SERIAL_1:
+            *value = snapshot.serial_number >> 16;
+            break;
+        case REGISTER_SERIAL_2:
+            *value = snapshot.serial_number & 0xFFFF;
+            break;
+        case REGISTER_ALARMS:
+            *value = module_value(0);
+            break;
+        case REGISTER_STATE:
+            *value = module_value(1);
+            break;
+        case REGISTER_MINIMUM_MSG ... REGISTER_MAXIMUM_MSG - 1:
+            *value = snapshot.minimum_message[index - REGISTER_MINIMUM_MSG];
+            break;
+        case REGISTER_MAXIMUM_MSG ... REGISTER_MAXIMUM_MSG + MESSAGE_NUM_REGISTERS - 1:
+            *value = snapshot.maximum_message[index - REGISTER_MAXIMUM_MSG];
+            break;
+        case REGISTER_PRESSURE:
+            *value = snapshot.pressure;
+            break;
+        case REGISTER_TEMPERATURE:
+            *value = snapshot.temperature;
+            break;
+        case REGISTER_HUMIDITY:
+            *value = snapshot.humidity;
+            break;
+        case REGISTER_OSR:
+            *value = snapshot.pressure_osr;
+            break;
+        case REGISTER_WINDOW:
+            *value = snapshot.pressure_window;
+            break;
+        case REGISTER_FILTER ... REGISTER_FILTER + 2:
+            *value = snapshot.filters[index - REGISTER_FILTER];
+            break;
+        case REGISTER_REJECTED:
+            *value = module_value(0);
+            break;
+        case REGISTER_CAPTURE ... REGISTER_CAPTURE + 3:
+            *value = module_value(index - REGISTER_CAPTURE);
+            break;
+        case REGISTER_CAPTURE_DATA ... REGISTER_TIMING - 1:
+            *value = module_value(index - REGISTER_CAPTURE_DATA);
+            break;
+        case REGISTER_TIMING ... REGISTER_PERIOD - 1:
+            *value = module_value(index - REGISTER_TIMING);
+            break;
+        case REGISTER_PERIOD:
+            *value = snapshot.pressure_period;
+            break;
+        case REGISTER_OVERRUNS ... REGISTER_OVERRUNS + 1:
+            *value = module_value(index - REGISTER_OVERRUNS);
+            break;
+        case REGISTER_SLOPE:
+            *value = module_value(0);
+            break;
+        case REGISTER_SLOPE_ALARM:
+            *value = snapshot.pressure_slope_alarm;
+            break;
+        case REGISTER_STATS_WINDOW:
+            *value = snapshot.statistics_window;
+            break;
+        case REGISTER_STATS_RESET:
+            *value = snapshot.statistics_reset_on_read;
+            break;
+        case REGISTER_STATISTICS ... REGISTER_LATENCY - 1:
+            *value = module_value(index - REGISTER_STATISTICS);
+            break;
+        case REGISTER_LATENCY ... REGISTERS_NUM - 1:
+            *value = module_value(index - REGISTER_LATENCY);
+            break;
+    }
+    return 0;
+}
+
+
+// Called through a pointer, as lightmodbus does
+static int (*volatile callback)(query_t query, uint16_t index, uint16_t *value) = switch_callback;
+
+
+/*
+ *  What the generic FC3 parser does: all the checks first, then all the reads
+ */
+static void read_switch(uint16_t first, uint16_t count, uint16_t *values) {
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t value = 0;
+        if (callback(QUERY_R_CHECK, first + i, &value)) {
+            return;
+        }
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        callback(QUERY_R, first + i, &values[i]);
+    }
+}
+
+
+SNAPSHOT_READER(address);
+SNAPSHOT_READER(class);
+SNAPSHOT_READER(pressure);
+SNAPSHOT_READER(temperature);
+SNAPSHOT_READER(humidity);
+SNAPSHOT_READER(pressure_osr);
+SNAPSHOT_READER(pressure_window);
+SNAPSHOT_READER(pressure_period);
+SNAPSHOT_READER(pressure_slope_alarm);
+SNAPSHOT_READER(statistics_window);
+SNAPSHOT_READER(statistics_reset_on_read);
+
+static uint16_t read_firmware(const snapshot_t *snapshot, uint16_t offset) {
+    (void)snapshot;
+    (void)offset;
+    return 0x0102;
+}
+
+static uint16_t read_serial_number(const snapshot_t *snapshot, uint16_t offset) {
+    return offset == 0 ? snapshot->serial_number >> 16 : snapshot->serial_number & 0xFFFF;
+}
+
+static uint16_t read_minimum_message(const snapshot_t *snapshot, uint16_t offset) {
+    return snapshot->minimum_message[offset];
+}
+
+static uint16_t read_maximum_message(const snapshot_t *snapshot, uint16_t offset) {
+    return snapshot->maximum_message[offset];
+}
+
+static uint16_t read_filter(const snapshot_t *snapshot, uint16_t offset) {
+    return snapshot->filters[offset];
+}
+
+static uint16_t read_module(const snapshot_t *snapshot, uint16_t offset) {
+    (void)snapshot;
+    return module_value(offset);
+}
+
+
+static const descriptor_t registers[REGISTERS_NUM] = {
+    REGISTER(REGISTER_ADDRESS, read_address),
+    REGISTER(REGISTER_FIRMWARE, read_firmware),
+    REGISTER(REGISTER_CLASS, read_class),
+    REGISTERS(REGISTER_SERIAL_1, REGISTER_SERIAL_2, read_serial_number),
+    REGISTERS(REGISTER_ALARMS, REGISTER_STATE, read_module),
+    REGISTERS(REGISTER_MINIMUM_MSG, REGISTER_MAXIMUM_MSG - 1, read_minimum_message),
+    REGISTERS(REGISTER_MAXIMUM_MSG, REGISTER_MAXIMUM_MSG + MESSAGE_NUM_REGISTERS - 1, read_maximum_message),
+    REGISTER(REGISTER_PRESSURE, read_pressure),
+    REGISTER(REGISTER_TEMPERATURE, read_temperature),
+    REGISTER(REGISTER_HUMIDITY, read_humidity),
+    REGISTER(REGISTER_OSR, read_pressure_osr),
+    REGISTER(REGISTER_WINDOW, read_pressure_window),
+    REGISTERS(REGISTER_FILTER, REGISTER_FILTER + 2, read_filter),
+    REGISTER(REGISTER_REJECTED, read_module),
+    REGISTERS(REGISTER_CAPTURE, REGISTER_CAPTURE + 3, read_module),
+    REGISTERS(REGISTER_CAPTURE_DATA, REGISTER_TIMING - 1, read_module),
+    REGISTERS(REGISTER_TIMING, REGISTER_PERIOD - 1, read_module),
+    REGISTER(REGISTER_PERIOD, read_pressure_period),
+    REGISTERS(REGISTER_OVERRUNS, REGISTER_OVERRUNS + 1, read_module),
+    REGISTER(REGISTER_SLOPE, read_module),
+    REGISTER(REGISTER_SLOPE_ALARM, read_pressure_slope_alarm),
+    REGISTER(REGISTER_STATS_WINDOW, read_statistics_window),
+    REGISTER(REGISTER_STATS_RESET, read_statistics_reset_on_read),
+    REGISTERS(REGISTER_STATISTICS, REGISTER_LATENCY - 1, read_module),
+    REGISTERS(REGISTER_LATENCY, REGISTERS_NUM - 1, read_module),
+};
+
+
+/*
+ *  Same loop as holding_registers_read()
+ */
+static void read_table(uint16_t first, uint16_t count, uint16_t *values) {
+    static const descriptor_t unmapped = {0};
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t            index      = first + i;
+        const descriptor_t *descriptor = index < REGISTERS_NUM ? &registers[index] : &unmapped;
+
+        if (descriptor->access & ACCESS_READ) {
+            values[i] = descriptor->read(&snapshot, index - descriptor->base);
+        } else {
+            values[i] = 0;
+        }
+    }
+}
+
+
+static struct {
+    const char *name;
+    uint16_t    first;
+    uint16_t    count;
+} requests[] = {
+    {"identity", REGISTER_ADDRESS, 7},
+    {"messages", REGISTER_MINIMUM_MSG, MESSAGE_NUM_REGISTERS * 2},
+    {"readings", REGISTER_PRESSURE, 3},
+    {"configuration", REGISTER_OSR, 6},
+    {"capture page", REGISTER_CAPTURE_DATA, 120},
+    {"statistics", REGISTER_STATISTICS, 18},
+};
+static size_t request = 0;
+
+
+static void bench_switch(void) {
+    uint16_t values[MAX_READ_REGISTERS];
+    read_switch(requests[request].first, requests[request].count, values);
+    bench_sink += values[0];
+}
+
+
+// The switch alone, one direct call per register
+static void bench_switch_only(void) {
+    uint16_t values[MAX_READ_REGISTERS];
+    for (uint16_t i = 0; i < requests[request].count; i++) {
+        switch_callback(QUERY_R, requests[request].first + i, &values[i]);
+    }
+    bench_sink += values[0];
+}
+
+
+static void bench_table(void) {
+    uint16_t values[MAX_READ_REGISTERS];
+    read_table(requests[request].first, requests[request].count, values);
+    bench_sink += values[0];
+}
+
+
+int main(void) {
+    uint8_t mismatch = 0;
+
+    for (size_t i = 0; i < sizeof(other_module) / sizeof(other_module[0]); i++) {
+        other_module[i] = i * 7;
+    }
+
+    printf("Modelled on host, both register maps are transcribed from minion.c\n");
+    printf("%-14s %9s %14s %12s %11s %8s\n", "request", "registers", "callbacks (ns)", "switch (ns)", "table (ns)",
+           "speedup");
+    for (request = 0; request < sizeof(requests) / sizeof(requests[0]); request++) {
+        uint16_t old_values[MAX_READ_REGISTERS] = {0};
+        uint16_t new_values[MAX_READ_REGISTERS] = {0};
+        read_switch(requests[request].first, requests[request].count, old_values);
+        read_table(requests[request].first, requests[request].count, new_values);
+        mismatch |= memcmp(old_values, new_values, sizeof(old_values)) != 0;
+
+        double callbacks_ns = bench_run(bench_switch, 200000);
+        double switch_ns    = bench_run(bench_switch_only, 200000);
+        double table_ns     = bench_run(bench_table, 200000);
+        printf("%-14s %9i %14.1f %12.1f %11.1f %7.2fx\n", requests[request].name, requests[request].count,
+               callbacks_ns, switch_ns, table_ns, callbacks_ns / table_ns);
+    }
+
+    if (mismatch) {
+        printf("The two implementations read different values\n");
+        return 1;
+    }
+    return 0;
+}
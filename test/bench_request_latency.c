@@ -0,0 +1,371 @@
+/*
+ *  Request to response latency of the two ways the device has received Modbus requests, replayed on host threads
+ *  against a bus paced at 115200 baud. The UART driver is modelled as on the ESP32-C3: a data event every 120 bytes
+ *  (RX FIFO threshold) and one when the RX timeout expires after the last byte.
+ *  - notify: every data event wakes the controller, which parses whatever has been received so far
+ *  - framer: the UART task feeds the RTU framer and hands complete frames to the Modbus task through a queue
+ *  Latency goes from the RX timeout event, where PROFILER_STAGE_REQUEST_TO_RESPONSE starts, to the response write.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "rtu_framer.h"
+
+
+#define BAUD_RATE         115200
+#define CHARACTER_NS      (11 * 1000000000ULL / BAUD_RATE)
+#define FIFO_THRESHOLD    120
+#define RX_TIMEOUT_NS     (3 * CHARACTER_NS)
+#define MASTER_TIMEOUT_NS 50000000ULL
+#define OUR_ADDRESS       1
+#define SHORT_REQUESTS    200
+#define LONG_REQUESTS     20
+#define QUEUE_SIZE        16
+
+
+typedef struct {
+    size_t  size;
+    uint8_t timeout_flag;
+} uart_event_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    size_t          item_size;
+    uint8_t         items[QUEUE_SIZE][sizeof(size_t) + RTU_FRAMER_MAX_SIZE];
+    size_t          first;
+    size_t          count;
+    uint8_t         stop;
+} queue_t;
+
+
+static uint16_t crc(const uint8_t *data, size_t len);
+static size_t   build_frame(uint8_t *frame, const uint8_t *pdu, size_t len);
+static void     queue_init(queue_t *queue, size_t item_size);
+static void     queue_send(queue_t *queue, const void *item);
+static int      queue_receive(queue_t *queue, void *item);
+static void     queue_stop(queue_t *queue);
+
+
+// UART driver: the bytes received so far and the event queue
+static pthread_mutex_t rx_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t         rx_data[1024];
+static size_t          rx_length = 0;
+static queue_t         uart_queue;
+
+// Hand over to the controller (notify) or to the Modbus task (framer)
+static queue_t notifications;
+static queue_t frames;
+
+// Response of the device, seen by the master
+static pthread_mutex_t response_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  response_cond;
+static uint64_t        response_time = 0;
+
+
+static size_t uart_read_bytes(uint8_t *buffer, size_t len) {
+    pthread_mutex_lock(&rx_lock);
+    if (len > rx_length) {
+        len = rx_length;
+    }
+    memcpy(buffer, rx_data, len);
+    memmove(rx_data, &rx_data[len], rx_length - len);
+    rx_length -= len;
+    pthread_mutex_unlock(&rx_lock);
+    return len;
+}
+
+
+/*
+ *  Parses the request and answers if it is a valid one for us, as serve_request() does
+ */
+static void serve(const uint8_t *buffer, size_t len) {
+    if (len < 4 || crc(buffer, len) != 0 || buffer[0] != OUR_ADDRESS) {
+        return;
+    }
+
+    pthread_mutex_lock(&response_lock);
+    response_time = bench_nanoseconds();
+    pthread_cond_signal(&response_cond);
+    pthread_mutex_unlock(&response_lock);
+}
+
+
+static void *notify_uart_task(void *args) {
+    (void)args;
+    uart_event_t event;
+    uint8_t      notification = 1;
+
+    while (queue_receive(&uart_queue, &event)) {
+        queue_send(&notifications, &notification);
+    }
+    return NULL;
+}
+
+
+static void *notify_controller_task(void *args) {
+    (void)args;
+    uint8_t notification = 0;
+    uint8_t buffer[256];
+
+    while (queue_receive(&notifications, &notification)) {
+        serve(buffer, uart_read_bytes(buffer, sizeof(buffer)));
+    }
+    return NULL;
+}
+
+
+static void *framer_uart_task(void *args) {
+    (void)args;
+    static rtu_framer_t framer;
+    uint8_t             chunk[128];
+    uint8_t             frame[sizeof(size_t) + RTU_FRAMER_MAX_SIZE];
+    uart_event_t        event;
+
+    rtu_framer_reset(&framer);
+    while (queue_receive(&uart_queue, &event)) {
+        size_t read = 0;
+        while ((read = uart_read_bytes(chunk, sizeof(chunk))) > 0) {
+            rtu_framer_feed(&framer, chunk, read);
+        }
+
+        if (event.timeout_flag) {
+            size_t length = 0;
+            rtu_framer_idle(&framer);
+            while ((length = rtu_framer_pop(&framer, &frame[sizeof(size_t)], RTU_FRAMER_MAX_SIZE)) > 0) {
+                memcpy(frame, &length, sizeof(length));
+                queue_send(&frames, frame);
+            }
+        }
+    }
+    return NULL;
+}
+
+
+static void *framer_modbus_task(void *args) {
+    (void)args;
+    uint8_t frame[sizeof(size_t) + RTU_FRAMER_MAX_SIZE];
+
+    while (queue_receive(&frames, frame)) {
+        size_t length = 0;
+        memcpy(&length, frame, sizeof(length));
+        serve(&frame[sizeof(size_t)], length);
+    }
+    return NULL;
+}
+
+
+static void sleep_until(uint64_t deadline) {
+    uint64_t now = bench_nanoseconds();
+    if (deadline > now) {
+        uint64_t        remaining = deadline - now;
+        struct timespec delay     = {.tv_sec = remaining / 1000000000ULL, .tv_nsec = remaining % 1000000000ULL};
+        nanosleep(&delay, NULL);
+    }
+}
+
+
+/*
+ *  Sends the request on the bus as the UART driver would report it, then waits for the response like a master.
+ *  Returns the latency in nanoseconds, 0 if the master timed out.
+ */
+static uint64_t transact(const uint8_t *request, size_t len) {
+    uint64_t start = bench_nanoseconds();
+    size_t   sent  = 0;
+
+    pthread_mutex_lock(&response_lock);
+    response_time = 0;
+    pthread_mutex_unlock(&response_lock);
+
+    while (sent < len) {
+        size_t       chunk = len - sent > FIFO_THRESHOLD ? FIFO_THRESHOLD : len - sent;
+        uart_event_t event = {.size = chunk, .timeout_flag = sent + chunk == len};
+
+        sleep_until(start + (sent + chunk) * CHARACTER_NS + (event.timeout_flag ? RX_TIMEOUT_NS : 0));
+
+        pthread_mutex_lock(&rx_lock);
+        memcpy(&rx_data[rx_length], &request[sent], chunk);
+        rx_length += chunk;
+        pthread_mutex_unlock(&rx_lock);
+        sent += chunk;
+
+        if (event.timeout_flag) {
+            start = bench_nanoseconds();
+        }
+        queue_send(&uart_queue, &event);
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_nsec += MASTER_TIMEOUT_NS;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+
+    pthread_mutex_lock(&response_lock);
+    while (response_time == 0) {
+        if (pthread_cond_timedwait(&response_cond, &response_lock, &deadline) != 0) {
+            break;
+        }
+    }
+    uint64_t latency = response_time > 0 ? response_time - start : 0;
+    pthread_mutex_unlock(&response_lock);
+
+    // Idle bus before the next request
+    sleep_until(bench_nanoseconds() + 4 * RX_TIMEOUT_NS);
+    return latency;
+}
+
+
+static int compare(const void *a, const void *b) {
+    uint64_t first  = *(const uint64_t *)a;
+    uint64_t second = *(const uint64_t *)b;
+    return (first > second) - (first < second);
+}
+
+
+static void report(const char *name, uint64_t *latencies, size_t count) {
+    size_t served = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (latencies[i] > 0) {
+            latencies[served++] = latencies[i];
+        }
+    }
+
+    if (served == 0) {
+        printf("  %-22s served %3zu/%-3zu\n", name, served, count);
+        return;
+    }
+
+    qsort(latencies, served, sizeof(latencies[0]), compare);
+    printf("  %-22s served %3zu/%-3zu  p50 %7.1f us  p99 %7.1f us  max %7.1f us\n", name, served, count,
+           latencies[served / 2] / 1000.0, latencies[(served * 99) / 100] / 1000.0, latencies[served - 1] / 1000.0);
+}
+
+
+static void run(const char *name, void *(*uart_task)(void *), void *(*serving_task)(void *), queue_t *handover,
+                size_t handover_size) {
+    uint8_t   short_request[8];
+    uint8_t   long_request[RTU_FRAMER_MAX_SIZE];
+    uint64_t  short_latencies[SHORT_REQUESTS];
+    uint64_t  long_latencies[LONG_REQUESTS];
+    pthread_t threads[2];
+
+    // Read 8 holding registers, and write 123 of them in the largest frame allowed
+    uint8_t read[]         = {OUR_ADDRESS, 3, 0x01, 0x00, 0, 8};
+    uint8_t write[7 + 246] = {OUR_ADDRESS, 16, 0x01, 0x00, 0, 123, 246};
+    for (size_t i = 7; i < sizeof(write); i++) {
+        write[i] = i;
+    }
+    size_t short_len = build_frame(short_request, read, sizeof(read));
+    size_t long_len  = build_frame(long_request, write, sizeof(write));
+
+    queue_init(&uart_queue, sizeof(uart_event_t));
+    queue_init(handover, handover_size);
+    rx_length = 0;
+    pthread_create(&threads[0], NULL, uart_task, NULL);
+    pthread_create(&threads[1], NULL, serving_task, NULL);
+
+    for (size_t i = 0; i < SHORT_REQUESTS; i++) {
+        short_latencies[i] = transact(short_request, short_len);
+    }
+    for (size_t i = 0; i < LONG_REQUESTS; i++) {
+        long_latencies[i] = transact(long_request, long_len);
+    }
+
+    queue_stop(&uart_queue);
+    queue_stop(handover);
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+
+    printf("%s\n", name);
+    report("FC3 read, 8 bytes", short_latencies, SHORT_REQUESTS);
+    report("FC16 write, 255 bytes", long_latencies, LONG_REQUESTS);
+}
+
+
+int main(void) {
+    // The master timeout is measured on the same clock as the latencies
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&response_cond, &attributes);
+
+    run("notify (controller parses on every UART data event)", notify_uart_task, notify_controller_task, &notifications,
+        sizeof(uint8_t));
+    run("framer (complete frames to the Modbus task)", framer_uart_task, framer_modbus_task, &frames,
+        sizeof(size_t) + RTU_FRAMER_MAX_SIZE);
+    return 0;
+}
+
+
+static void queue_init(queue_t *queue, size_t item_size) {
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->cond, NULL);
+    queue->item_size = item_size;
+    queue->first     = 0;
+    queue->count     = 0;
+    queue->stop      = 0;
+}
+
+
+// Never blocks, the item is dropped if the queue is full
+static void queue_send(queue_t *queue, const void *item) {
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count < QUEUE_SIZE) {
+        memcpy(queue->items[(queue->first + queue->count) % QUEUE_SIZE], item, queue->item_size);
+        queue->count++;
+        pthread_cond_signal(&queue->cond);
+    }
+    pthread_mutex_unlock(&queue->lock);
+}
+
+
+// Blocks until an item arrives; returns 0 once the queue is stopped
+static int queue_receive(queue_t *queue, void *item) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && !queue->stop) {
+        pthread_cond_wait(&queue->cond, &queue->lock);
+    }
+
+    int received = queue->count > 0;
+    if (received) {
+        memcpy(item, queue->items[queue->first], queue->item_size);
+        queue->first = (queue->first + 1) % QUEUE_SIZE;
+        queue->count--;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return received;
+}
+
+
+static void queue_stop(queue_t *queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->stop = 1;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+
+static size_t build_frame(uint8_t *frame, const uint8_t *pdu, size_t len) {
+    memcpy(frame, pdu, len);
+    uint16_t value = crc(frame, len);
+    frame[len]     = value & 0xFF;
+    frame[len + 1] = value >> 8;
+    return len + 2;
+}
+
+
+/*
+ *  Bitwise Modbus CRC16, the same loop lightmodbus runs
+ */
+static uint16_t crc(const uint8_t *data, size_t len) {
+    uint16_t value = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        value ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            value = (value & 1) ? (value >> 1) ^ 0xA001 : value >> 1;
+        }
+    }
+    return value;
+}
@@ -0,0 +1,149 @@
+/*
+ *  Cost of averaging the sensor ring buffers. The baseline sensors_read() walked the whole MS5837 and SHTC3 buffers
+ *  under the sensor mutex on every read; the moving average of filter.c keeps a running sum updated on insertion
+ *  and eviction. A push stores one sample in each buffer, as the samplers do; a read computes all the averages, as
+ *  the readers do, and is the part that used to run with the mutex taken.
+ */
+#include <stdio.h>
+#include "bench.h"
+#include "filter.h"
+
+
+#define NUM_SAMPLES_SHTC3 5
+#define MAX_WINDOW        200     // APP_CONFIG_MAXIMUM_PRESSURE_WINDOW
+#define STEPS             1000
+
+
+static const uint16_t windows[] = {10, 50, 200};
+static uint16_t       window    = 0;
+
+// Baseline layout: two ADC buffers for the MS5837, two for the SHTC3
+static uint32_t temperature_adc_buffer[MAX_WINDOW];
+static uint32_t pressure_adc_buffer[MAX_WINDOW];
+static double   temperatures[NUM_SAMPLES_SHTC3];
+static double   humidities[NUM_SAMPLES_SHTC3];
+static size_t   ms5837_sample_index = 0;
+static uint8_t  ms5837_full_circle  = 0;
+static size_t   shtc3_sample_index  = 0;
+static uint8_t  shtc3_full_circle   = 0;
+
+static int32_t  temperature_filter_buffer[MAX_WINDOW];
+static int32_t  pressure_filter_buffer[MAX_WINDOW];
+static int32_t  shtc3_temperature_filter_buffer[NUM_SAMPLES_SHTC3];
+static int32_t  humidity_filter_buffer[NUM_SAMPLES_SHTC3];
+static filter_t temperature_filter;
+static filter_t pressure_filter;
+static filter_t shtc3_temperature_filter;
+static filter_t humidity_filter;
+
+/*
+ *  Same loops as the baseline sensors_read()
+ */
+__attribute__((noinline)) static void walk_read(double *temperature, double *pressure, double *humidity) {
+    size_t   ms5837_total    = ms5837_full_circle ? window : ms5837_sample_index;
+    uint64_t temperature_sum = 0;
+    uint64_t pressure_sum    = 0;
+
+    for (size_t i = 0; i < ms5837_total; i++) {
+        temperature_sum += temperature_adc_buffer[i];
+        pressure_sum += pressure_adc_buffer[i];
+    }
+
+    size_t shtc3_total           = shtc3_full_circle ? NUM_SAMPLES_SHTC3 : shtc3_sample_index;
+    double shtc3_temperature_sum = 0;
+    double humidity_sum          = 0;
+
+    for (size_t i = 0; i < shtc3_total; i++) {
+        shtc3_temperature_sum += temperatures[i];
+        humidity_sum += humidities[i];
+    }
+
+    *temperature = shtc3_temperature_sum / shtc3_total;
+    *humidity    = humidity_sum / shtc3_total;
+    *pressure    = (double)pressure_sum / ms5837_total + (double)temperature_sum / ms5837_total;
+}
+
+
+static void walk_push(uint32_t sample) {
+    temperature_adc_buffer[ms5837_sample_index] = sample;
+    pressure_adc_buffer[ms5837_sample_index]    = sample * 3;
+    if (++ms5837_sample_index >= window) {
+        ms5837_full_circle  = 1;
+        ms5837_sample_index = 0;
+    }
+
+    temperatures[shtc3_sample_index] = sample;
+    humidities[shtc3_sample_index]   = sample / 2;
+    if (++shtc3_sample_index >= NUM_SAMPLES_SHTC3) {
+        shtc3_full_circle  = 1;
+        shtc3_sample_index = 0;
+    }
+}
+
+
+static void bench_walk_push(void) {
+    for (uint32_t i = 0; i < STEPS; i++) {
+        walk_push(8000000 + i);
+    }
+}
+
+
+static void bench_walk_read(void) {
+    for (uint32_t i = 0; i < STEPS; i++) {
+        double temperature, pressure, humidity;
+        walk_read(&temperature, &pressure, &humidity);
+        bench_sink += (uint32_t)(temperature + pressure + humidity);
+    }
+}
+
+
+__attribute__((noinline)) static void running_read(int32_t *temperature, int32_t *pressure, int32_t *humidity) {
+    *temperature = filter_output(&shtc3_temperature_filter);
+    *humidity    = filter_output(&humidity_filter);
+    *pressure    = filter_output(&pressure_filter) + filter_output(&temperature_filter);
+}
+
+
+static void bench_running_push(void) {
+    for (uint32_t i = 0; i < STEPS; i++) {
+        filter_push(&temperature_filter, 8000000 + i);
+        filter_push(&pressure_filter, (8000000 + i) * 3);
+        filter_push(&shtc3_temperature_filter, 8000000 + i);
+        filter_push(&humidity_filter, (8000000 + i) / 2);
+    }
+}
+
+
+static void bench_running_read(void) {
+    for (uint32_t i = 0; i < STEPS; i++) {
+        int32_t temperature, pressure, humidity;
+        running_read(&temperature, &pressure, &humidity);
+        bench_sink += temperature + pressure + humidity;
+    }
+}
+
+
+int main(void) {
+    filter_init(&temperature_filter, temperature_filter_buffer, MAX_WINDOW);
+    filter_init(&pressure_filter, pressure_filter_buffer, MAX_WINDOW);
+    filter_init(&shtc3_temperature_filter, shtc3_temperature_filter_buffer, NUM_SAMPLES_SHTC3);
+    filter_init(&humidity_filter, humidity_filter_buffer, NUM_SAMPLES_SHTC3);
+
+    printf("%-7s %24s %24s %13s\n", "window", "walk: push / read (ns)", "sums: push / read (ns)", "read speedup");
+    for (size_t i = 0; i < sizeof(windows) / sizeof(windows[0]); i++) {
+        window = windows[i];
+        filter_configure(&temperature_filter, FILTER_TYPE_MOVING_AVERAGE, window);
+        filter_configure(&pressure_filter, FILTER_TYPE_MOVING_AVERAGE, window);
+
+        // The pushes go first, so the reads see full buffers
+        double walk_push    = bench_run(bench_walk_push, 100) / STEPS;
+        double walk_read    = bench_run(bench_walk_read, 100) / STEPS;
+        double running_push = bench_run(bench_running_push, 100) / STEPS;
+        double running_read = bench_run(bench_running_read, 100) / STEPS;
+
+        printf("%-7u %11.1f / %10.1f %11.1f / %10.1f %12.1fx\n", window, walk_push, walk_read, running_push,
+               running_read, walk_read / running_read);
+    }
+
+    return 0;
+}
@@ -0,0 +1,290 @@
+#ifndef CAPTURES_H_INCLUDED
+#define CAPTURES_H_INCLUDED
+
+/*
+ *  Bus traffic of a master and several devices as a listening device receives it: each burst holds the bytes
+ *  returned by the UART between two RX timeouts. The frame lengths are the split the framer is expected to find.
+ *  Some full size writes carry data that zeroes the CRC residue before the end of the frame.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+#define CAPTURE_BURST(burst)                                                                                           \
+    { burst, sizeof(burst) }
+#define CAPTURE(name, bursts, frames)                                                                                  \
+    { name, bursts, sizeof(bursts) / sizeof(bursts[0]), frames, sizeof(frames) / sizeof(frames[0]) }
+
+
+typedef struct {
+    const uint8_t *bytes;
+    size_t         len;
+} capture_burst_t;
+
+
+typedef struct {
+    const char            *name;
+    const capture_burst_t *bursts;
+    size_t                 num_bursts;
+    const size_t          *frames;
+    size_t                 num_frames;
+} capture_t;
+
+
+// Master polling four devices, every frame followed by T3.5
+static const uint8_t polling_burst_0[] = {
+    // Read 4 holding registers from device 1
+    0x01, 0x03, 0x01, 0x00, 0x00, 0x04, 0x45, 0xF5,
+};
+static const uint8_t polling_burst_1[] = {
+    // Response
+    0x01, 0x03, 0x08, 0xA5, 0xCD, 0x4D, 0x3C, 0xCA, 0x26, 0x18, 0xB8, 0xC8, 0xE5,
+};
+static const uint8_t polling_burst_2[] = {
+    // Read 4 holding registers from device 2
+    0x02, 0x03, 0x01, 0x00, 0x00, 0x04, 0x45, 0xC6,
+};
+static const uint8_t polling_burst_3[] = {
+    // Response
+    0x02, 0x03, 0x08, 0x25, 0x16, 0x30, 0x31, 0xBB, 0x3B, 0x1D, 0xB2, 0x8B, 0x4D,
+};
+static const uint8_t polling_burst_4[] = {
+    // Read 4 holding registers from device 3
+    0x03, 0x03, 0x01, 0x00, 0x00, 0x04, 0x44, 0x17,
+};
+static const uint8_t polling_burst_5[] = {
+    // Response
+    0x03, 0x03, 0x08, 0x6D, 0xEC, 0x13, 0x32, 0x2C, 0x01, 0xDE, 0x06, 0xCF, 0x85,
+};
+static const uint8_t polling_burst_6[] = {
+    // Read 4 holding registers from device 4
+    0x04, 0x03, 0x01, 0x00, 0x00, 0x04, 0x45, 0xA0,
+};
+static const uint8_t polling_burst_7[] = {
+    // Response
+    0x04, 0x03, 0x08, 0xD6, 0x1A, 0x23, 0xC4, 0x7B, 0x38, 0x2E, 0x71, 0x00, 0x83,
+};
+static const capture_burst_t polling_bursts[] = {
+    CAPTURE_BURST(polling_burst_0),
+    CAPTURE_BURST(polling_burst_1),
+    CAPTURE_BURST(polling_burst_2),
+    CAPTURE_BURST(polling_burst_3),
+    CAPTURE_BURST(polling_burst_4),
+    CAPTURE_BURST(polling_burst_5),
+    CAPTURE_BURST(polling_burst_6),
+    CAPTURE_BURST(polling_burst_7),
+};
+static const size_t polling_frames[] = {8, 13, 8, 13, 8, 13, 8, 13};
+
+
+// Responses and the next request sent without waiting T3.5
+static const uint8_t back_to_back_burst_0[] = {
+    // Read 8 holding registers from device 5
+    0x05, 0x03, 0x00, 0x00, 0x00, 0x08, 0x45, 0x88,
+    // Response, no gap
+    0x05, 0x03, 0x10, 0xD9, 0x5A, 0x1E, 0x43, 0x3F, 0x62, 0x72, 0x4C, 0x1F, 0xAC, 0xCB, 0x19, 0x19,
+    0x63, 0x71, 0x31, 0xE5, 0x73,
+    // Next write, no gap
+    0x05, 0x06, 0x00, 0x10, 0x17, 0xD9, 0x47, 0xE1,
+};
+static const uint8_t back_to_back_burst_1[] = {
+    // Echo of the write
+    0x05, 0x06, 0x00, 0x10, 0x17, 0xD9, 0x47, 0xE1,
+};
+static const uint8_t back_to_back_burst_2[] = {
+    // Read 8 holding registers from device 6
+    0x06, 0x03, 0x00, 0x00, 0x00, 0x08, 0x45, 0xBB,
+    // Response, no gap
+    0x06, 0x03, 0x10, 0x44, 0x2F, 0x94, 0x47, 0xD6, 0x99, 0x49, 0xDB, 0x3C, 0x4F, 0x9D, 0xF1, 0x5C,
+    0x88, 0x34, 0xC3, 0x50, 0x01,
+    // Next write, no gap
+    0x06, 0x06, 0x00, 0x10, 0x60, 0x30, 0xA1, 0xAC,
+};
+static const uint8_t back_to_back_burst_3[] = {
+    // Echo of the write
+    0x06, 0x06, 0x00, 0x10, 0x60, 0x30, 0xA1, 0xAC,
+};
+static const uint8_t back_to_back_burst_4[] = {
+    // Read 8 holding registers from device 7
+    0x07, 0x03, 0x00, 0x00, 0x00, 0x08, 0x44, 0x6A,
+    // Response, no gap
+    0x07, 0x03, 0x10, 0xBE, 0xAA, 0x31, 0xE2, 0x20, 0x25, 0x1E, 0x84, 0x69, 0x73, 0xFE, 0x2A, 0xDA,
+    0xED, 0xA0, 0xD7, 0xED, 0x97,
+    // Next write, no gap
+    0x07, 0x06, 0x00, 0x10, 0xEE, 0x63, 0x85, 0xE0,
+};
+static const uint8_t back_to_back_burst_5[] = {
+    // Echo of the write
+    0x07, 0x06, 0x00, 0x10, 0xEE, 0x63, 0x85, 0xE0,
+};
+static const uint8_t back_to_back_burst_6[] = {
+    // Broadcast, user defined function code
+    0x00, 0x44, 0x12, 0x34, 0x56, 0x78, 0x8B, 0x20,
+    // Read from device 9
+    0x09, 0x03, 0x40, 0x00, 0x00, 0x01, 0x90, 0x82,
+    // Illegal address exception
+    0x09, 0x83, 0x02, 0x41, 0x33,
+};
+static const uint8_t back_to_back_burst_7[] = {
+    // Write to device 10
+    0x0A, 0x10, 0x00, 0x20, 0x00, 0x02, 0x04, 0x00, 0x01, 0x00, 0x02, 0x04, 0x92,
+    // Illegal value exception
+    0x0A, 0x90, 0x03, 0x7D, 0xC3,
+};
+static const capture_burst_t back_to_back_bursts[] = {
+    CAPTURE_BURST(back_to_back_burst_0),
+    CAPTURE_BURST(back_to_back_burst_1),
+    CAPTURE_BURST(back_to_back_burst_2),
+    CAPTURE_BURST(back_to_back_burst_3),
+    CAPTURE_BURST(back_to_back_burst_4),
+    CAPTURE_BURST(back_to_back_burst_5),
+    CAPTURE_BURST(back_to_back_burst_6),
+    CAPTURE_BURST(back_to_back_burst_7),
+};
+static const size_t back_to_back_frames[] = {8, 21, 8, 8, 8, 21, 8, 8, 8, 21, 8, 8, 8, 8, 5, 13, 5};
+
+
+// Full size FC16 writes whose data happens to zero the CRC residue before the end
+static const uint8_t long_writes_burst_0[] = {
+    // Write of 123 registers to device 11, zero residue after 8 bytes
+    0x0B, 0x10, 0x18, 0x1B, 0x00, 0x7B, 0xF6, 0x27, 0xE8, 0xB9, 0x99, 0x7F, 0x5C, 0x7C, 0x29, 0x99,
+    0xFD, 0xAF, 0xE5, 0x93, 0x25, 0x3C, 0xD6, 0x54, 0xAF, 0x4D, 0xFA, 0xD7, 0x14, 0x27, 0xA0, 0xAE,
+    0xB3, 0xFE, 0xE9, 0x23, 0x2F, 0x8A, 0xF2, 0x21, 0x1F, 0x9E, 0xE4, 0x91, 0xC5, 0xB1, 0x0B, 0xEC,
+    0xB5, 0x56, 0x3B, 0xFC, 0x1E, 0x6F, 0x93, 0x42, 0x7E, 0xCB, 0xC8, 0xFE, 0x29, 0x55, 0xE5, 0xCD,
+    0x8E, 0x46, 0xDC, 0x8E, 0xD4, 0xB7, 0xC2, 0x76, 0x4D, 0x2A, 0x5A, 0x4D, 0x76, 0x77, 0x06, 0xF8,
+    0x5D, 0x86, 0x90, 0x02, 0x4A, 0xD6, 0xBD, 0xA3, 0x40, 0x1B, 0xE9, 0xC8, 0xCB, 0xCC, 0xC9, 0x35,
+    0xF6, 0xCD, 0x1F, 0x61, 0x22, 0x6A, 0xE1, 0x53, 0x38, 0xAE, 0x1A, 0x34, 0x00, 0x4D, 0x33, 0xBA,
+    0x0D, 0x24, 0x6A, 0xC0, 0x4C, 0x81, 0xB1, 0xBA, 0xF2, 0x3E, 0x3B, 0xF9, 0xEE, 0xF5, 0xF7, 0x9F,
+    0x2B, 0x49, 0x34, 0xAF, 0x87, 0xF5, 0x52, 0x0B, 0x69, 0xB9, 0x4B, 0x0D, 0x98, 0x2E, 0x85, 0xBB,
+    0x55, 0xB6, 0x72, 0xA8, 0x72, 0x63, 0x7A, 0xCD, 0x74, 0x66, 0xFC, 0xB6, 0x0E, 0x0E, 0x8F, 0xF1,
+    0x84, 0x63, 0xB0, 0xE4, 0xB2, 0xBA, 0x29, 0x70, 0x34, 0x74, 0xF0, 0x64, 0xAC, 0x68, 0xF7, 0x00,
+    0xF5, 0xB0, 0x2B, 0x3D, 0xC6, 0x66, 0xF4, 0x5B, 0xDE, 0xAA, 0x2C, 0xCA, 0xED, 0xCD, 0x2B, 0x51,
+    0x57, 0x41, 0x0E, 0x4D, 0xEE, 0x4A, 0xF2, 0xB3, 0x4F, 0x43, 0x0A, 0x07, 0x34, 0x47, 0xDE, 0x63,
+    0x6C, 0x0E, 0x80, 0x6C, 0x95, 0x7B, 0xA6, 0x84, 0xD6, 0x43, 0x1F, 0xB5, 0xEA, 0xD7, 0x42, 0x4D,
+    0x09, 0xE1, 0x5D, 0x02, 0x4C, 0x58, 0x48, 0xF2, 0x3D, 0x1F, 0xA6, 0xF7, 0x36, 0x1D, 0x7F, 0x61,
+    0x8D, 0x15, 0x32, 0xE7, 0x0E, 0x20, 0xE2, 0xA6, 0x66, 0x8D, 0xE7, 0xF4, 0x7E, 0x65, 0xF0,
+};
+static const uint8_t long_writes_burst_1[] = {
+    // Write of 100 registers to device 12, zero residue after 100 bytes
+    0x0C, 0x10, 0x02, 0x00, 0x00, 0x64, 0xC8, 0x84, 0x67, 0xE5, 0x46, 0xD5, 0x3E, 0xC8, 0xE2, 0xA1,
+    0x25, 0x7B, 0xDB, 0x25, 0x6C, 0x9B, 0x3E, 0x4F, 0xBB, 0x49, 0x81, 0x46, 0xEF, 0x70, 0x30, 0xCB,
+    0xF9, 0x53, 0x72, 0x52, 0xDC, 0xCE, 0xAD, 0xD7, 0x64, 0xB6, 0xA3, 0x2F, 0xBB, 0x09, 0xAD, 0xEA,
+    0xE1, 0x09, 0xC4, 0xA9, 0x97, 0x20, 0x39, 0x75, 0x35, 0x2B, 0x87, 0x8B, 0x14, 0x5C, 0x8A, 0x42,
+    0xD8, 0x84, 0xCF, 0x4C, 0xFD, 0xA7, 0x2D, 0x8E, 0x1D, 0x5D, 0xD9, 0x25, 0x89, 0x08, 0x2D, 0x85,
+    0x2A, 0x71, 0x22, 0x87, 0x3E, 0xE8, 0x05, 0xAD, 0xD5, 0x89, 0x42, 0x16, 0x7A, 0x38, 0x52, 0x86,
+    0x19, 0x5C, 0x28, 0x62, 0x9C, 0x69, 0x94, 0xE4, 0x5B, 0x8A, 0xB1, 0x09, 0x80, 0x12, 0x07, 0x09,
+    0x61, 0xF3, 0x7D, 0xE4, 0x36, 0xDD, 0xFD, 0xC9, 0x9D, 0x6E, 0x75, 0xAF, 0x65, 0x47, 0xCF, 0xB1,
+    0x1B, 0x42, 0x07, 0x24, 0x82, 0xDC, 0x53, 0x1C, 0x2B, 0xC3, 0x90, 0x7C, 0x96, 0x17, 0xEB, 0x5E,
+    0x50, 0x89, 0xE4, 0x01, 0x86, 0xBA, 0xA8, 0xA5, 0x7D, 0x11, 0x9E, 0x6F, 0xB6, 0x5D, 0x00, 0xAB,
+    0xC3, 0x2A, 0xF3, 0x8E, 0x66, 0x7F, 0x02, 0x2E, 0x87, 0x2D, 0x49, 0xCC, 0x15, 0xC9, 0x0B, 0x99,
+    0x9B, 0x77, 0x2B, 0x4F, 0xC7, 0xA6, 0xFD, 0x4C, 0x91, 0x4A, 0x16, 0xDB, 0x47, 0x08, 0x75, 0x2B,
+    0x0F, 0x15, 0x44, 0xB8, 0x35, 0xC0, 0xE7, 0x19, 0x09, 0x7D, 0xFA, 0x87, 0x01, 0xE9, 0x23, 0x65,
+    0xA4,
+};
+static const uint8_t long_writes_burst_2[] = {
+    // Same write to device 11
+    0x0B, 0x10, 0x18, 0x1B, 0x00, 0x7B, 0xF6, 0x27, 0xE8, 0xB9, 0x99, 0x7F, 0x5C, 0x7C, 0x29, 0x99,
+    0xFD, 0xAF, 0xE5, 0x93, 0x25, 0x3C, 0xD6, 0x54, 0xAF, 0x4D, 0xFA, 0xD7, 0x14, 0x27, 0xA0, 0xAE,
+    0xB3, 0xFE, 0xE9, 0x23, 0x2F, 0x8A, 0xF2, 0x21, 0x1F, 0x9E, 0xE4, 0x91, 0xC5, 0xB1, 0x0B, 0xEC,
+    0xB5, 0x56, 0x3B, 0xFC, 0x1E, 0x6F, 0x93, 0x42, 0x7E, 0xCB, 0xC8, 0xFE, 0x29, 0x55, 0xE5, 0xCD,
+    0x8E, 0x46, 0xDC, 0x8E, 0xD4, 0xB7, 0xC2, 0x76, 0x4D, 0x2A, 0x5A, 0x4D, 0x76, 0x77, 0x06, 0xF8,
+    0x5D, 0x86, 0x90, 0x02, 0x4A, 0xD6, 0xBD, 0xA3, 0x40, 0x1B, 0xE9, 0xC8, 0xCB, 0xCC, 0xC9, 0x35,
+    0xF6, 0xCD, 0x1F, 0x61, 0x22, 0x6A, 0xE1, 0x53, 0x38, 0xAE, 0x1A, 0x34, 0x00, 0x4D, 0x33, 0xBA,
+    0x0D, 0x24, 0x6A, 0xC0, 0x4C, 0x81, 0xB1, 0xBA, 0xF2, 0x3E, 0x3B, 0xF9, 0xEE, 0xF5, 0xF7, 0x9F,
+    0x2B, 0x49, 0x34, 0xAF, 0x87, 0xF5, 0x52, 0x0B, 0x69, 0xB9, 0x4B, 0x0D, 0x98, 0x2E, 0x85, 0xBB,
+    0x55, 0xB6, 0x72, 0xA8, 0x72, 0x63, 0x7A, 0xCD, 0x74, 0x66, 0xFC, 0xB6, 0x0E, 0x0E, 0x8F, 0xF1,
+    0x84, 0x63, 0xB0, 0xE4, 0xB2, 0xBA, 0x29, 0x70, 0x34, 0x74, 0xF0, 0x64, 0xAC, 0x68, 0xF7, 0x00,
+    0xF5, 0xB0, 0x2B, 0x3D, 0xC6, 0x66, 0xF4, 0x5B, 0xDE, 0xAA, 0x2C, 0xCA, 0xED, 0xCD, 0x2B, 0x51,
+    0x57, 0x41, 0x0E, 0x4D, 0xEE, 0x4A, 0xF2, 0xB3, 0x4F, 0x43, 0x0A, 0x07, 0x34, 0x47, 0xDE, 0x63,
+    0x6C, 0x0E, 0x80, 0x6C, 0x95, 0x7B, 0xA6, 0x84, 0xD6, 0x43, 0x1F, 0xB5, 0xEA, 0xD7, 0x42, 0x4D,
+    0x09, 0xE1, 0x5D, 0x02, 0x4C, 0x58, 0x48, 0xF2, 0x3D, 0x1F, 0xA6, 0xF7, 0x36, 0x1D, 0x7F, 0x61,
+    0x8D, 0x15, 0x32, 0xE7, 0x0E, 0x20, 0xE2, 0xA6, 0x66, 0x8D, 0xE7, 0xF4, 0x7E, 0x65, 0xF0,
+    // Response, no gap
+    0x0B, 0x10, 0x18, 0x1B, 0x00, 0x7B, 0xF6, 0x27,
+    // Next poll, no gap
+    0x04, 0x03, 0x00, 0x00, 0x00, 0x02, 0xC4, 0x5E,
+};
+static const uint8_t long_writes_burst_3[] = {
+    // Write of 123 registers to device 13, zero residue after 49 bytes
+    0x0D, 0x10, 0x00, 0x00, 0x00, 0x7B, 0xF6, 0x2F, 0x21, 0xF2, 0x81, 0x26, 0x87, 0x78, 0x69, 0x76,
+    0xEB, 0xFC, 0xC3, 0x27, 0xF5, 0x93, 0x17, 0x65, 0x27, 0x4B, 0xA9, 0x82, 0x9B, 0x44, 0x06, 0xF6,
+    0x1F, 0xF8, 0x89, 0x32, 0x6F, 0xFA, 0x94, 0x92, 0xED, 0xEE, 0xEE, 0x3C, 0x66, 0x9F, 0x2B, 0xAB,
+    0x95, 0x94, 0xEA, 0x27, 0xE6, 0x89, 0xC6, 0x6B, 0x6B, 0x26, 0x2E, 0x48, 0x86, 0xB8, 0x43, 0x8F,
+    0x39, 0xBA, 0x76, 0xFE, 0xF8, 0xC9, 0x0C, 0x51, 0x01, 0xFB, 0xE6, 0xCF, 0x9A, 0x48, 0xD5, 0xB0,
+    0xC0, 0xA1, 0x3D, 0xA9, 0x00, 0xA6, 0xAD, 0xCB, 0x3D, 0x64, 0x06, 0x94, 0x81, 0xBE, 0x21, 0xC9,
+    0xC7, 0x27, 0xB8, 0xDB, 0x8C, 0x18, 0x8F, 0x34, 0x1A, 0x92, 0x4C, 0x7F, 0x88, 0xDF, 0xA1, 0x61,
+    0xBF, 0xDB, 0x0E, 0xCC, 0x68, 0x29, 0x19, 0xD2, 0xE6, 0x46, 0x92, 0xF8, 0x19, 0x41, 0x57, 0xF1,
+    0xD4, 0xAF, 0x90, 0x98, 0x82, 0x85, 0xCF, 0x7A, 0x9A, 0xF7, 0xC9, 0x3D, 0x55, 0x52, 0x26, 0x6A,
+    0xFE, 0x70, 0xE7, 0xAA, 0xE6, 0xDA, 0x47, 0x62, 0x7C, 0x2E, 0x59, 0xAF, 0x2E, 0xA3, 0x7A, 0xBC,
+    0x84, 0x67, 0x0A, 0xD3, 0xC4, 0xD3, 0x6B, 0xC0, 0x8A, 0xAD, 0x1F, 0xFF, 0x8E, 0xB8, 0x40, 0x6E,
+    0x2F, 0x8A, 0x7F, 0xC4, 0xCC, 0xE4, 0xDD, 0x9F, 0x0B, 0x41, 0x10, 0xD9, 0xF2, 0xFA, 0x00, 0x25,
+    0xC8, 0xEF, 0xE5, 0x7F, 0x37, 0x72, 0x4F, 0x4D, 0x37, 0xEA, 0x2B, 0x14, 0x00, 0x40, 0x77, 0x13,
+    0x9B, 0x41, 0x80, 0xDF, 0x39, 0x32, 0x24, 0x99, 0x62, 0xC6, 0x85, 0x72, 0x00, 0x05, 0x9A, 0xEB,
+    0x8E, 0xA1, 0x7C, 0xF3, 0x78, 0x7E, 0x0E, 0xD2, 0x9D, 0x1C, 0x0B, 0x63, 0xFF, 0xD7, 0x29, 0x83,
+    0x74, 0xD9, 0xBD, 0x74, 0xFC, 0x11, 0xAD, 0xD7, 0xB9, 0xCA, 0x65, 0x03, 0x95, 0x58, 0x81,
+    // Response, no gap
+    0x0D, 0x10, 0x00, 0x00, 0x00, 0x7B, 0x80, 0xE6,
+};
+static const capture_burst_t long_writes_bursts[] = {
+    CAPTURE_BURST(long_writes_burst_0),
+    CAPTURE_BURST(long_writes_burst_1),
+    CAPTURE_BURST(long_writes_burst_2),
+    CAPTURE_BURST(long_writes_burst_3),
+};
+static const size_t long_writes_frames[] = {255, 209, 255, 8, 8, 255, 8};
+
+
+// Frames with function codes of unknown length
+static const uint8_t user_defined_burst_0[] = {
+    // Broadcast, user defined function code, zero residue after 20 bytes
+    0x00, 0x41, 0x22, 0x69, 0xFD, 0x66, 0x9F, 0x63, 0x76, 0xEE, 0x71, 0x87, 0x97, 0x37, 0xFD, 0x5F,
+    0x72, 0xF8, 0xE9, 0x73, 0x4A, 0xC9, 0x1B, 0x6D, 0x0C, 0x48, 0xD4, 0x1A, 0x1E, 0x5E, 0xC9, 0xE6,
+    0xA0, 0x39, 0x28, 0x54, 0xA8, 0x61, 0x5E, 0xEF, 0x10, 0x9F, 0x3A, 0x68,
+};
+static const uint8_t user_defined_burst_1[] = {
+    // User defined function code for device 3
+    0x03, 0x42, 0xC1, 0xBF, 0xA9, 0xE2, 0x56, 0x37, 0x01, 0x28, 0x8F, 0x29, 0xCB, 0x45,
+    // Read, no gap
+    0x03, 0x03, 0x01, 0x00, 0x00, 0x02, 0xC4, 0x15,
+};
+static const capture_burst_t user_defined_bursts[] = {
+    CAPTURE_BURST(user_defined_burst_0),
+    CAPTURE_BURST(user_defined_burst_1),
+};
+static const size_t user_defined_frames[] = {44, 14, 8};
+
+
+// Truncated frames and line noise, returned as is for the parser to reject
+static const uint8_t noise_burst_0[] = {
+    // Request cut short
+    0x02, 0x03, 0x01, 0x00, 0x00,
+};
+static const uint8_t noise_burst_1[] = {
+    // Complete request
+    0x02, 0x03, 0x01, 0x00, 0x00, 0x04, 0x45, 0xC6,
+};
+static const uint8_t noise_burst_2[] = {
+    // Complete request
+    0x02, 0x03, 0x01, 0x00, 0x00, 0x04, 0x45, 0xC6,
+    // Noise, no gap
+    0x00, 0xFF, 0x13,
+};
+static const capture_burst_t noise_bursts[] = {
+    CAPTURE_BURST(noise_burst_0),
+    CAPTURE_BURST(noise_burst_1),
+    CAPTURE_BURST(noise_burst_2),
+};
+static const size_t noise_frames[] = {5, 8, 8, 3};
+
+
+static const capture_t captures[] = {
+    CAPTURE("polling", polling_bursts, polling_frames),
+    CAPTURE("back_to_back", back_to_back_bursts, back_to_back_frames),
+    CAPTURE("long_writes", long_writes_bursts, long_writes_frames),
+    CAPTURE("user_defined", user_defined_bursts, user_defined_frames),
+    CAPTURE("noise", noise_bursts, noise_frames),
+};
+
+
+#endif
@@ -0,0 +1,142 @@
+#include <math.h>
+#include <stdio.h>
+#include "compensation.h"
+
+
+#define CHECK(condition, ...)                                                                                          \
+    if (!(condition)) {                                                                                                \
+        printf("%s:%i: ", __FILE__, __LINE__);                                                                         \
+        printf(__VA_ARGS__);                                                                                           \
+        printf("\n");                                                                                                  \
+        failures++;                                                                                                    \
+    }
+
+// Version field of the first PROM word
+#define VERSION(version) ((uint16_t)((version) << 5))
+
+
+static int    init_with_crc(compensation_ms5837_t *compensation, uint16_t *prom, uint16_t version);
+static double reference_pressure(const uint16_t *prom, uint32_t temperature_adc, uint32_t pressure_adc,
+                                 double *temperature);
+static void   test_datasheet_example(void);
+static void   test_temperature_range(void);
+static void   test_variant(void);
+
+
+// Calibration coefficients of the MS5837-02BA datasheet example
+static const uint16_t datasheet_prom[COMPENSATION_MS5837_PROM_WORDS] = {0, 46372, 43981, 29059, 27842, 31553, 28165};
+
+static size_t failures = 0;
+
+
+int main(void) {
+    test_datasheet_example();
+    test_temperature_range();
+    test_variant();
+
+    printf("%zu failures\n", failures);
+    return failures > 0;
+}
+
+
+/*
+ *  D1 = 6465444 and D2 = 8077636 give 20.00 C and 1100.02 mBar
+ */
+static void test_datasheet_example(void) {
+    compensation_ms5837_t compensation;
+    uint16_t              prom[COMPENSATION_MS5837_PROM_WORDS];
+    int32_t               temperature = 0;
+
+    CHECK(init_with_crc(&compensation, prom, 0x00) == 0, "example: PROM rejected");
+    int32_t pressure = compensation_ms5837_calculate(&compensation, 8077636, 6465444, &temperature);
+    CHECK(temperature == 2000, "example: temperature %i instead of 2000", temperature);
+    CHECK(pressure == 110002, "example: pressure %i instead of 110002", pressure);
+}
+
+
+/*
+ *  From -20 to 85 C, the operating range, against the datasheet formulas in double: below 20 C the second order
+ *  terms are where the variants differ
+ */
+static void test_temperature_range(void) {
+    compensation_ms5837_t compensation;
+    uint16_t              prom[COMPENSATION_MS5837_PROM_WORDS];
+    const uint32_t        pressure_adcs[] = {4000000, 5600000, 6465444, 7500000, 9000000};
+
+    CHECK(init_with_crc(&compensation, prom, 0x15) == 0, "range: PROM rejected");
+    for (int32_t celsius = -20; celsius <= 85; celsius++) {
+        int64_t  delta           = ((int64_t)(celsius * 100 - 2000) << 23) / prom[6];
+        uint32_t temperature_adc = (uint32_t)((int64_t)prom[5] * 256 + delta);
+
+        for (size_t i = 0; i < sizeof(pressure_adcs) / sizeof(pressure_adcs[0]); i++) {
+            int32_t temperature          = 0;
+            double  expected_temperature = 0;
+            int32_t pressure =
+                compensation_ms5837_calculate(&compensation, temperature_adc, pressure_adcs[i], &temperature);
+            double expected = reference_pressure(prom, temperature_adc, pressure_adcs[i], &expected_temperature);
+
+            CHECK(fabs(pressure - expected) <= 1, "range %i C, D1 %u: pressure %i instead of %.2f", celsius,
+                  pressure_adcs[i], pressure, expected);
+            CHECK(fabs(temperature - expected_temperature) <= 1, "range %i C: temperature %i instead of %.2f", celsius,
+                  temperature, expected_temperature);
+        }
+    }
+}
+
+
+/*
+ *  Only the 02BA versions are accepted, the 30BA PROM is rejected instead of being compensated with the wrong formulas
+ */
+static void test_variant(void) {
+    compensation_ms5837_t compensation;
+    uint16_t              prom[COMPENSATION_MS5837_PROM_WORDS];
+
+    CHECK(init_with_crc(&compensation, prom, 0x00) == 0, "variant: 02BA01 rejected");
+    CHECK(init_with_crc(&compensation, prom, 0x15) == 0, "variant: 02BA21 rejected");
+    CHECK(init_with_crc(&compensation, prom, 0x1A) == -2, "variant: 30BA26 accepted");
+
+    init_with_crc(&compensation, prom, 0x00);
+    prom[0] ^= 0x1000;
+    CHECK(compensation_ms5837_init(&compensation, prom) == -1, "variant: wrong CRC accepted");
+}
+
+
+/*
+ *  Fills `prom` with the datasheet coefficients and `version`, looking for the CRC nibble that makes it valid.
+ *  Returns the result of `compensation_ms5837_init` for that nibble, or -1 if no nibble passes the CRC
+ */
+static int init_with_crc(compensation_ms5837_t *compensation, uint16_t *prom, uint16_t version) {
+    for (size_t i = 0; i < COMPENSATION_MS5837_PROM_WORDS; i++) {
+        prom[i] = datasheet_prom[i];
+    }
+
+    int res = -1;
+    for (uint16_t crc = 0; crc < 16 && res == -1; crc++) {
+        prom[0] = (uint16_t)(crc << 12) | VERSION(version);
+        res     = compensation_ms5837_init(compensation, prom);
+    }
+    return res;
+}
+
+
+/*
+ *  First and second order compensation of the 02BA datasheet, in Pa and 0.01 C
+ */
+static double reference_pressure(const uint16_t *prom, uint32_t temperature_adc, uint32_t pressure_adc,
+                                 double *temperature) {
+    double dt   = (double)temperature_adc - prom[5] * pow(2, 8);
+    // TEMP is an integer in the datasheet and the second order terms are computed from it
+    double temp = floor(2000 + dt * prom[6] / pow(2, 23));
+    double off  = prom[2] * pow(2, 17) + prom[4] * dt / pow(2, 6);
+    double sens = prom[1] * pow(2, 16) + prom[3] * dt / pow(2, 7);
+
+    double ti = 0, offi = 0, sensi = 0;
+    if (temp < 2000) {
+        ti    = 11 * dt * dt / pow(2, 35);
+        offi  = 31 * (temp - 2000) * (temp - 2000) / pow(2, 3);
+        sensi = 63 * (temp - 2000) * (temp - 2000) / pow(2, 5);
+    }
+
+    *temperature = temp - ti;
+    return (pressure_adc * (sens - sensi) / pow(2, 21) - (off - offi)) / pow(2, 15);
+}
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <string.h>
+#include "rtu_framer.h"
+#include "captures.h"
+
+
+#define CHECK(condition, ...)                                                                                          \
+    if (!(condition)) {                                                                                                \
+        printf("%s:%i: ", __FILE__, __LINE__);                                                                         \
+        printf(__VA_ARGS__);                                                                                           \
+        printf("\n");                                                                                                  \
+        failures++;                                                                                                    \
+    }
+
+
+static void test_capture(const capture_t *capture, size_t chunk_size);
+static void test_captures_in_a_row(void);
+static void test_overflow(void);
+static void test_frames_full(void);
+static void test_ring_full(void);
+
+
+static size_t failures = 0;
+
+
+int main(void) {
+    const size_t chunk_sizes[] = {RTU_FRAMER_MAX_SIZE, 1, 2, 3, 7, 16, 120};
+
+    for (size_t i = 0; i < sizeof(captures) / sizeof(captures[0]); i++) {
+        for (size_t j = 0; j < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); j++) {
+            test_capture(&captures[i], chunk_sizes[j]);
+        }
+    }
+    test_captures_in_a_row();
+    test_overflow();
+    test_frames_full();
+    test_ring_full();
+
+    printf("%zu failures\n", failures);
+    return failures > 0;
+}
+
+
+/*
+ *  Feeds the bytes of a burst in chunks of `chunk_size`, as the UART task would read them
+ */
+static void feed_burst(rtu_framer_t *framer, const capture_burst_t *burst, size_t chunk_size) {
+    for (size_t i = 0; i < burst->len; i += chunk_size) {
+        size_t len = burst->len - i < chunk_size ? burst->len - i : chunk_size;
+        rtu_framer_feed(framer, &burst->bytes[i], len);
+    }
+}
+
+
+/*
+ *  Replays the capture one burst at a time and checks that the frames popped follow the expected split and add up to
+ *  the bytes received
+ */
+static void check_capture(rtu_framer_t *framer, const capture_t *capture, size_t chunk_size) {
+    uint8_t frame[RTU_FRAMER_MAX_SIZE];
+    size_t  frame_index = 0;
+    size_t  burst_index = 0;
+    size_t  byte_index  = 0;
+
+    for (size_t i = 0; i < capture->num_bursts; i++) {
+        feed_burst(framer, &capture->bursts[i], chunk_size);
+        rtu_framer_idle(framer);
+
+        size_t length = 0;
+        while ((length = rtu_framer_pop(framer, frame, sizeof(frame))) > 0) {
+            CHECK(frame_index < capture->num_frames, "%s (chunks of %zu): unexpected frame of %zu bytes", capture->name,
+                  chunk_size, length);
+            if (frame_index >= capture->num_frames) {
+                return;
+            }
+
+            CHECK(length == capture->frames[frame_index], "%s (chunks of %zu): frame %zu is %zu bytes instead of %zu",
+                  capture->name, chunk_size, frame_index, length, capture->frames[frame_index]);
+
+            for (size_t j = 0; j < length; j++) {
+                if (byte_index == capture->bursts[burst_index].len) {
+                    burst_index++;
+                    byte_index = 0;
+                }
+                CHECK(frame[j] == capture->bursts[burst_index].bytes[byte_index],
+                      "%s (chunks of %zu): frame %zu differs at byte %zu", capture->name, chunk_size, frame_index, j);
+                byte_index++;
+            }
+            frame_index++;
+        }
+    }
+
+    CHECK(frame_index == capture->num_frames, "%s (chunks of %zu): %zu frames instead of %zu", capture->name,
+          chunk_size, frame_index, capture->num_frames);
+}
+
+
+static void test_capture(const capture_t *capture, size_t chunk_size) {
+    static rtu_framer_t framer;
+    rtu_framer_reset(&framer);
+    check_capture(&framer, capture, chunk_size);
+}
+
+
+/*
+ *  The same framer over all captures, wrapping around the ring buffer many times
+ */
+static void test_captures_in_a_row(void) {
+    static rtu_framer_t framer;
+    rtu_framer_reset(&framer);
+
+    for (size_t round = 0; round < 16; round++) {
+        for (size_t i = 0; i < sizeof(captures) / sizeof(captures[0]); i++) {
+            check_capture(&framer, &captures[i], 1 + round);
+        }
+    }
+}
+
+
+/*
+ *  A burst longer than any frame is dropped, the frames before and after it are not affected
+ */
+static void test_overflow(void) {
+    static rtu_framer_t framer;
+    uint8_t             frame[RTU_FRAMER_MAX_SIZE];
+    uint8_t             noise[RTU_FRAMER_MAX_SIZE + 44];
+    const uint8_t      *request = captures[0].bursts[0].bytes;
+    size_t              len     = captures[0].bursts[0].len;
+
+    memset(noise, 0x55, sizeof(noise));
+    rtu_framer_reset(&framer);
+
+    rtu_framer_feed(&framer, request, len);
+    rtu_framer_feed(&framer, noise, sizeof(noise));
+    rtu_framer_idle(&framer);
+    CHECK(rtu_framer_pop(&framer, frame, sizeof(frame)) == len, "overflow: the frame before the noise is lost");
+    CHECK(rtu_framer_pop(&framer, frame, sizeof(frame)) == 0, "overflow: the noise is returned");
+
+    rtu_framer_feed(&framer, request, len);
+    rtu_framer_idle(&framer);
+    CHECK(rtu_framer_pop(&framer, frame, sizeof(frame)) == len, "overflow: the frame after the noise is lost");
+    CHECK(memcmp(frame, request, len) == 0, "overflow: the frame after the noise is corrupted");
+}
+
+
+/*
+ *  Feeds `count` copies of a frame without popping them and returns how many could be popped afterwards
+ */
+static size_t fill(rtu_framer_t *framer, const capture_burst_t *burst, size_t count) {
+    uint8_t frame[RTU_FRAMER_MAX_SIZE];
+    size_t  popped = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        feed_burst(framer, burst, burst->len);
+        rtu_framer_idle(framer);
+    }
+
+    while (rtu_framer_pop(framer, frame, sizeof(frame)) > 0) {
+        CHECK(memcmp(frame, burst->bytes, burst->len) == 0, "full: frame %zu is corrupted", popped);
+        popped++;
+    }
+    return popped;
+}
+
+
+/*
+ *  Short frames that are never popped fill the list of frame ends, what does not fit is dropped
+ */
+static void test_frames_full(void) {
+    static rtu_framer_t framer;
+    rtu_framer_reset(&framer);
+
+    size_t popped = fill(&framer, &captures[0].bursts[0], RTU_FRAMER_MAX_FRAMES + 4);
+    CHECK(popped == RTU_FRAMER_MAX_FRAMES, "frames full: %zu frames instead of %i", popped, RTU_FRAMER_MAX_FRAMES);
+    popped = fill(&framer, &captures[0].bursts[0], 1);
+    CHECK(popped == 1, "frames full: no room after popping");
+}
+
+
+/*
+ *  Long frames that are never popped fill the ring buffer, what does not fit is dropped
+ */
+static void test_ring_full(void) {
+    static rtu_framer_t    framer;
+    const capture_burst_t *burst = &captures[2].bursts[0];
+    rtu_framer_reset(&framer);
+
+    size_t popped = fill(&framer, burst, 3);
+    CHECK(popped == RTU_FRAMER_BUFFER_SIZE / burst->len, "ring full: %zu frames instead of %zu", popped,
+          RTU_FRAMER_BUFFER_SIZE / burst->len);
+    popped = fill(&framer, burst, 1);
+    CHECK(popped == 1, "ring full: no room after popping");
+}
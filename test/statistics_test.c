@@ -0,0 +1,136 @@
+#include <math.h>
+#include <stdio.h>
+#include "statistics.h"
+
+
+#define CHECK(condition, ...)                                                                                          \
+    if (!(condition)) {                                                                                                \
+        printf("%s:%i: ", __FILE__, __LINE__);                                                                         \
+        printf(__VA_ARGS__);                                                                                           \
+        printf("\n");                                                                                                  \
+        failures++;                                                                                                    \
+    }
+
+// An hour at about 1 kHz, the longest window
+#define WINDOW_SAMPLES 3600000UL
+
+
+static void test_small(void);
+static void test_long_window(int32_t origin, int32_t spread);
+static void test_random(void);
+static void test_saturation(void);
+
+
+static size_t failures = 0;
+
+
+int main(void) {
+    test_small();
+    test_long_window(0, 1000);
+    test_long_window(-20000, 1000);
+    test_long_window(0, 32767);
+    test_long_window(-32768, 65535);
+    test_random();
+    test_saturation();
+
+    printf("%zu failures\n", failures);
+    return failures > 0;
+}
+
+
+static void test_small(void) {
+    statistics_t         statistics;
+    statistics_summary_t summary;
+    const int32_t        samples[] = {2, 4, 4, 4, 5, 5, 7, 9};
+
+    statistics_reset(&statistics);
+    statistics_summarize(&statistics, &summary);
+    CHECK(summary.count == 0 && summary.stddev == 0, "small: empty statistics are not zero");
+
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        statistics_add(&statistics, samples[i]);
+    }
+    statistics_summarize(&statistics, &summary);
+    CHECK(summary.count == 8, "small: count %u", summary.count);
+    CHECK(summary.min == 2 && summary.max == 9, "small: min %i max %i", summary.min, summary.max);
+    CHECK(summary.mean == 5, "small: mean %i", summary.mean);
+    CHECK(summary.stddev == 2, "small: stddev %i", summary.stddev);
+}
+
+
+/*
+ *  Alternates `origin` and `origin + spread` for a whole window: the mean is halfway and the standard deviation is
+ *  half the spread
+ */
+static void test_long_window(int32_t origin, int32_t spread) {
+    statistics_t         statistics;
+    statistics_summary_t summary;
+
+    statistics_reset(&statistics);
+    for (uint32_t i = 0; i < WINDOW_SAMPLES; i++) {
+        statistics_add(&statistics, origin + (i % 2 ? spread : 0));
+    }
+    statistics_summarize(&statistics, &summary);
+
+    int32_t mean = (int32_t)floor(origin + spread / 2.0 + 0.5);
+    CHECK(summary.count == WINDOW_SAMPLES, "long window %i/%i: count %u", origin, spread, summary.count);
+    CHECK(summary.mean == mean, "long window %i/%i: mean %i instead of %i", origin, spread, summary.mean, mean);
+    CHECK(summary.stddev == spread / 2, "long window %i/%i: stddev %i instead of %i", origin, spread, summary.stddev,
+          spread / 2);
+}
+
+
+/*
+ *  Random int16 samples against a double reference
+ */
+static void test_random(void) {
+    statistics_t         statistics;
+    statistics_summary_t summary;
+    uint32_t             seed = 1;
+    double               sum  = 0;
+    double               sum_squares = 0;
+
+    statistics_reset(&statistics);
+    for (uint32_t i = 0; i < WINDOW_SAMPLES; i++) {
+        seed           = seed * 1103515245 + 12345;
+        int32_t sample = (int32_t)((seed >> 8) % 40000) - 5000;
+        statistics_add(&statistics, sample);
+        sum += sample;
+        sum_squares += (double)sample * sample;
+    }
+    statistics_summarize(&statistics, &summary);
+
+    double mean   = sum / WINDOW_SAMPLES;
+    double stddev = sqrt(sum_squares / WINDOW_SAMPLES - mean * mean);
+    CHECK(fabs(summary.mean - mean) <= 0.5, "random: mean %i instead of %.2f", summary.mean, mean);
+    CHECK(fabs(summary.stddev - stddev) < 1, "random: stddev %i instead of %.2f", summary.stddev, stddev);
+}
+
+
+/*
+ *  Past STATISTICS_MAX_COUNT the sums stop growing, the summary still describes the samples accumulated so far
+ */
+static void test_saturation(void) {
+    statistics_t         statistics;
+    statistics_summary_t summary;
+    const int32_t        spread = 65535;
+
+    // As if 0 and `spread` had been alternated up to two samples before the limit
+    statistics_reset(&statistics);
+    statistics_add(&statistics, 0);
+    statistics.count       = STATISTICS_MAX_COUNT - 2;
+    statistics.max         = spread;
+    statistics.sum         = (int64_t)spread * (STATISTICS_MAX_COUNT / 2 - 1);
+    statistics.sum_squares = (int64_t)spread * spread * (STATISTICS_MAX_COUNT / 2 - 1);
+
+    for (size_t i = 0; i < 100; i++) {
+        statistics_add(&statistics, i % 2 ? spread : 0);
+    }
+    statistics_add(&statistics, -1);
+    statistics_summarize(&statistics, &summary);
+
+    CHECK(summary.count == STATISTICS_MAX_COUNT, "saturation: count %u", summary.count);
+    CHECK(summary.min == -1, "saturation: the minimum is not updated");
+    CHECK(summary.mean == (spread + 1) / 2, "saturation: mean %i", summary.mean);
+    CHECK(summary.stddev == spread / 2, "saturation: stddev %i instead of %i", summary.stddev, spread / 2);
+}